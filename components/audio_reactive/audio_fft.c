@@ -0,0 +1,163 @@
+/*
+ * Fixed-point spectrum analysis for the audio-reactive pipeline
+ *
+ * Hann window, radix-2 Q15 FFT and grouping into log-spaced bands with
+ * per-band gain and bass beat detection. Kept apart from the I2S and task
+ * plumbing so it only depends on libc and libm.
+ */
+
+#include "audio_fft.h"
+
+#include <math.h>
+#include <string.h>
+
+#define BAND_FLOOR_Q4     (8 << 4)   // log2 band power below which a band reads as 0
+#define PEAK_DECAY_Q4     1          // Per-frame decay of the per-band peak tracker
+#define BEAT_HOLDOFF      8          // Minimum frames between beats (~185 ms)
+#define BEAT_MIN_ENERGY   4096
+
+// FFT tables and work area, built once by audioFft_init()
+static int16_t window[AUDIO_FFT_SIZE];
+static int16_t twiddleCos[AUDIO_FFT_SIZE / 2];
+static int16_t twiddleSin[AUDIO_FFT_SIZE / 2];
+static uint16_t bitReverse[AUDIO_FFT_SIZE];
+static int16_t fftRe[AUDIO_FFT_SIZE];
+static int16_t fftIm[AUDIO_FFT_SIZE];
+static uint16_t bandEdges[AUDIO_NUM_BANDS + 1];
+
+// Analysis state carried between frames
+static int16_t bandPeakQ4[AUDIO_NUM_BANDS];
+static uint32_t bassAverage;
+static uint32_t framesSinceBeat;
+
+static void buildTables()
+{
+  for (int i = 0; i < AUDIO_FFT_SIZE; i++) {
+    // Hann window in Q15
+    window[i] = (int16_t)(32767 * 0.5 * (1 - cos(2 * M_PI * i / (AUDIO_FFT_SIZE - 1))));
+
+    uint16_t rev = 0;
+    for (int b = 0; b < AUDIO_FFT_BITS; b++) {
+      rev |= ((i >> b) & 1) << (AUDIO_FFT_BITS - 1 - b);
+    }
+    bitReverse[i] = rev;
+  }
+
+  for (int i = 0; i < AUDIO_FFT_SIZE / 2; i++) {
+    twiddleCos[i] = (int16_t)(32767 * cos(2 * M_PI * i / AUDIO_FFT_SIZE));
+    twiddleSin[i] = (int16_t)(32767 * sin(2 * M_PI * i / AUDIO_FFT_SIZE));
+  }
+
+  // Log-spaced band edges from bin 1 to Nyquist, kept strictly increasing
+  double ratio = pow(AUDIO_FFT_SIZE / 2, 1.0 / AUDIO_NUM_BANDS);
+  bandEdges[0] = 1;
+  for (int b = 1; b <= AUDIO_NUM_BANDS; b++) {
+    uint16_t edge = (uint16_t)(pow(ratio, b) + 0.5);
+    bandEdges[b] = (edge > bandEdges[b - 1]) ? edge : bandEdges[b - 1] + 1;
+  }
+  bandEdges[AUDIO_NUM_BANDS] = AUDIO_FFT_SIZE / 2;
+}
+
+static void fft()
+{
+  // Radix-2 decimation in time on bit-reversed input. Every stage halves its
+  // outputs so Q15 values cannot overflow; the result is the DFT divided by N.
+  for (int size = 2; size <= AUDIO_FFT_SIZE; size <<= 1) {
+    int half = size >> 1;
+    int step = AUDIO_FFT_SIZE / size;
+    for (int start = 0; start < AUDIO_FFT_SIZE; start += size) {
+      for (int k = 0; k < half; k++) {
+        int32_t wr = twiddleCos[k * step];
+        int32_t wi = -twiddleSin[k * step];
+        int i = start + k;
+        int j = i + half;
+        int32_t tr = (wr * fftRe[j] - wi * fftIm[j]) >> 15;
+        int32_t ti = (wr * fftIm[j] + wi * fftRe[j]) >> 15;
+        fftRe[j] = (fftRe[i] - tr) >> 1;
+        fftIm[j] = (fftIm[i] - ti) >> 1;
+        fftRe[i] = (fftRe[i] + tr) >> 1;
+        fftIm[i] = (fftIm[i] + ti) >> 1;
+      }
+    }
+  }
+}
+
+static int log2Q4(uint32_t x)
+{
+  // log2(x) with 4 fractional bits, 0 for x == 0
+  if (x == 0) {
+    return 0;
+  }
+  int msb = 31 - __builtin_clz(x);
+  uint32_t mantissa = (msb >= 4) ? (x >> (msb - 4)) : (x << (4 - msb));
+  return (msb << 4) | (mantissa & 0x0f);
+}
+
+void audioFft_analyse(const int16_t * samples, audioBands_t * bands)
+{
+  for (int i = 0; i < AUDIO_FFT_SIZE; i++) {
+    fftRe[bitReverse[i]] = (samples[i] * window[i]) >> 15;
+    fftIm[bitReverse[i]] = 0;
+  }
+
+  fft();
+
+  uint32_t bassEnergy = 0;
+  for (int b = 0; b < AUDIO_NUM_BANDS; b++) {
+    uint64_t sum = 0;
+    for (int k = bandEdges[b]; k < bandEdges[b + 1]; k++) {
+      sum += (uint32_t)(fftRe[k] * fftRe[k]) + (uint32_t)(fftIm[k] * fftIm[k]);
+    }
+    uint32_t power = sum / (bandEdges[b + 1] - bandEdges[b]);
+    if (b < 2) {
+      bassEnergy += power;
+    }
+
+    // Per-band automatic gain: scale against a slowly decaying peak
+    int levelQ4 = log2Q4(power);
+    if (levelQ4 > bandPeakQ4[b]) {
+      bandPeakQ4[b] = levelQ4;
+    }
+    else if (bandPeakQ4[b] > BAND_FLOOR_Q4 + 16) {
+      bandPeakQ4[b] -= PEAK_DECAY_Q4;
+    }
+    int level = 0;
+    if (levelQ4 > BAND_FLOOR_Q4 && bandPeakQ4[b] > BAND_FLOOR_Q4) {
+      level = (levelQ4 - BAND_FLOOR_Q4) * 255 / (bandPeakQ4[b] - BAND_FLOOR_Q4);
+    }
+    bands->level[b] = (level > 255) ? 255 : level;
+  }
+
+  // Beat when the bass energy jumps 50% over its running average
+  framesSinceBeat++;
+  bands->beat = (bassEnergy > BEAT_MIN_ENERGY &&
+                 bassEnergy > bassAverage + bassAverage / 2 &&
+                 framesSinceBeat >= BEAT_HOLDOFF);
+  if (bands->beat) {
+    framesSinceBeat = 0;
+  }
+  bassAverage = bassAverage - bassAverage / 16 + bassEnergy / 16;
+}
+
+void audioFft_init()
+{
+  buildTables();
+  memset(bandPeakQ4, 0, sizeof(bandPeakQ4));
+  bassAverage = 0;
+  framesSinceBeat = 0;
+}
+
+uint32_t audioFft_binPower(int bin)
+{
+  return (uint32_t)(fftRe[bin] * fftRe[bin]) + (uint32_t)(fftIm[bin] * fftIm[bin]);
+}
+
+int audioFft_bandOfBin(int bin)
+{
+  for (int b = 0; b < AUDIO_NUM_BANDS; b++) {
+    if (bin >= bandEdges[b] && bin < bandEdges[b + 1]) {
+      return b;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,32 @@
+/*
+ * Fixed-point spectrum analysis for the audio-reactive pipeline
+ */
+
+#ifndef AUDIO_FFT_H
+#define AUDIO_FFT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "audio_reactive.h"
+
+// Builds the window, twiddle and band tables and clears the analysis state
+extern void audioFft_init();
+
+// Windows and transforms one frame of AUDIO_FFT_SIZE samples into bands.
+// Band gain and beat detection carry state from one call to the next.
+extern void audioFft_analyse(const int16_t * samples, audioBands_t * bands);
+
+// Power of one bin (0 to AUDIO_FFT_SIZE / 2) of the last analysed frame
+extern uint32_t audioFft_binPower(int bin);
+
+// Band a bin is grouped into, or -1 for bin 0 (DC)
+extern int audioFft_bandOfBin(int bin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUDIO_FFT_H */
@@ -0,0 +1,165 @@
+/*
+ * Audio-reactive analysis pipeline for driving LED strands from music
+ *
+ * capture task  --sampleFull-->  analysis task  --bandsFull-->  render task
+ *      ^                             |     ^                        |
+ *      +-------- sampleFree ---------+     +------ bandsFree -------+
+ *
+ * Every buffer is statically allocated; the queues only pass slot indices.
+ */
+
+#include "audio_reactive.h"
+#include "audio_fft.h"
+
+#include <string.h>
+
+#include <esp_timer.h>
+#include <driver/i2s.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#define SAMPLE_SLOTS      3     // One being captured, one being analysed, one spare
+#define BANDS_SLOTS       2
+#define SAMPLE_SHIFT      14    // 32-bit I2S slot to 16-bit sample, 4x gain
+
+static audioReactive_config_t audioConfig;
+static audioReactive_stats_t audioStats;
+
+// Pipeline buffers
+static int32_t rawSamples[AUDIO_FFT_SIZE];
+static int16_t sampleSlots[SAMPLE_SLOTS][AUDIO_FFT_SIZE];
+static audioBands_t bandsSlots[BANDS_SLOTS];
+static QueueHandle_t sampleFree, sampleFull, bandsFree, bandsFull;
+
+static void captureTask(void * _args)
+{
+  for (;;) {
+    size_t got = 0;
+    while (got < sizeof(rawSamples)) {
+      size_t bytesRead = 0;
+      i2s_read(audioConfig.i2sPort, (uint8_t *)rawSamples + got, sizeof(rawSamples) - got,
+               &bytesRead, portMAX_DELAY);
+      got += bytesRead;
+    }
+
+    uint8_t slot;
+    if (xQueueReceive(sampleFree, &slot, 0) != pdTRUE) {
+      // Analysis is behind; keep draining the I2S DMA and drop this frame
+      audioStats.overruns++;
+      continue;
+    }
+
+    // I2S microphones deliver 24-bit samples left-justified in 32-bit slots;
+    // keep a little gain over the top 16 bits and saturate
+    for (int i = 0; i < AUDIO_FFT_SIZE; i++) {
+      int32_t sample = rawSamples[i] >> SAMPLE_SHIFT;
+      sampleSlots[slot][i] = (sample > 32767) ? 32767 : (sample < -32768) ? -32768 : sample;
+    }
+    xQueueSend(sampleFull, &slot, portMAX_DELAY);
+  }
+}
+
+static void analysisTask(void * _args)
+{
+  uint32_t frame = 0;
+  for (;;) {
+    uint8_t slot, bandsSlot;
+    xQueueReceive(sampleFull, &slot, portMAX_DELAY);
+
+    if (xQueueReceive(bandsFree, &bandsSlot, 0) != pdTRUE) {
+      // Render is behind; skip analysis so capture keeps its buffers
+      audioStats.overruns++;
+      xQueueSend(sampleFree, &slot, portMAX_DELAY);
+      continue;
+    }
+
+    int64_t start = esp_timer_get_time();
+    audioFft_analyse(sampleSlots[slot], &bandsSlots[bandsSlot]);
+    bandsSlots[bandsSlot].frame = frame++;
+    uint32_t elapsed = esp_timer_get_time() - start;
+    if (elapsed > audioStats.fftUsMax) {
+      audioStats.fftUsMax = elapsed;
+    }
+
+    xQueueSend(sampleFree, &slot, portMAX_DELAY);
+    xQueueSend(bandsFull, &bandsSlot, portMAX_DELAY);
+  }
+}
+
+static void renderTask(void * _args)
+{
+  for (;;) {
+    uint8_t slot;
+    xQueueReceive(bandsFull, &slot, portMAX_DELAY);
+
+    int64_t start = esp_timer_get_time();
+    audioConfig.render(&bandsSlots[slot], audioConfig.renderArg);
+    uint32_t elapsed = esp_timer_get_time() - start;
+    if (elapsed > audioStats.renderUsMax) {
+      audioStats.renderUsMax = elapsed;
+    }
+    audioStats.frames++;
+
+    xQueueSend(bandsFree, &slot, portMAX_DELAY);
+  }
+}
+
+int audioReactive_init(const audioReactive_config_t * config)
+{
+  if (config->render == NULL) {
+    return -1;
+  }
+  audioConfig = *config;
+
+  memset(&audioStats, 0, sizeof(audioStats));
+  audioStats.frameBudgetUs = (uint64_t)AUDIO_FFT_SIZE * 1000000 / AUDIO_SAMPLE_RATE;
+
+  audioFft_init();
+
+  sampleFree = xQueueCreate(SAMPLE_SLOTS, sizeof(uint8_t));
+  sampleFull = xQueueCreate(SAMPLE_SLOTS, sizeof(uint8_t));
+  bandsFree = xQueueCreate(BANDS_SLOTS, sizeof(uint8_t));
+  bandsFull = xQueueCreate(BANDS_SLOTS, sizeof(uint8_t));
+  if (!sampleFree || !sampleFull || !bandsFree || !bandsFull) {
+    return -1;
+  }
+  for (uint8_t i = 0; i < SAMPLE_SLOTS; i++) {
+    xQueueSend(sampleFree, &i, 0);
+  }
+  for (uint8_t i = 0; i < BANDS_SLOTS; i++) {
+    xQueueSend(bandsFree, &i, 0);
+  }
+
+  i2s_config_t i2sConfig = {
+    .mode = I2S_MODE_MASTER | I2S_MODE_RX,
+    .sample_rate = AUDIO_SAMPLE_RATE,
+    .bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT,
+    .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
+    .communication_format = I2S_COMM_FORMAT_I2S | I2S_COMM_FORMAT_I2S_MSB,
+    .intr_alloc_flags = 0,
+    .dma_buf_count = 4,
+    .dma_buf_len = AUDIO_FFT_SIZE / 2,
+  };
+  i2s_pin_config_t pinConfig = {
+    .bck_io_num = config->bckPin,
+    .ws_io_num = config->wsPin,
+    .data_out_num = I2S_PIN_NO_CHANGE,
+    .data_in_num = config->dataPin,
+  };
+  if (i2s_driver_install(config->i2sPort, &i2sConfig, 0, NULL) != ESP_OK ||
+      i2s_set_pin(config->i2sPort, &pinConfig) != ESP_OK) {
+    return -1;
+  }
+
+  xTaskCreate(captureTask, "Audio capture", 2048, NULL, 5, NULL);
+  xTaskCreate(analysisTask, "Audio analysis", 2048, NULL, 4, NULL);
+  xTaskCreate(renderTask, "Audio render", 3072, NULL, 3, NULL);
+
+  return 0;
+}
+
+void audioReactive_getStats(audioReactive_stats_t * stats)
+{
+  *stats = audioStats;
+}
@@ -0,0 +1,56 @@
+/*
+ * Audio-reactive analysis pipeline for driving LED strands from music
+ *
+ * Samples are captured from an I2S microphone, windowed, run through a
+ * fixed-point FFT and grouped into log-spaced bands with simple beat
+ * detection. Capture, analysis and render run as separate tasks connected
+ * by queues of preallocated buffers, so no memory is allocated per frame.
+ */
+
+#ifndef AUDIO_REACTIVE_H
+#define AUDIO_REACTIVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define AUDIO_SAMPLE_RATE  22050
+#define AUDIO_FFT_BITS     9
+#define AUDIO_FFT_SIZE     (1 << AUDIO_FFT_BITS)  // Samples per frame (~23 ms at 22.05 kHz)
+#define AUDIO_NUM_BANDS    8
+
+typedef struct {
+  uint8_t level[AUDIO_NUM_BANDS];  // Per-band level scaled 0-255, lowest band first
+  uint8_t beat;                    // Nonzero on the frame a bass beat was detected
+  uint32_t frame;
+} audioBands_t;
+
+typedef void (*audioRender_t)(const audioBands_t * bands, void * arg);
+
+typedef struct {
+  int i2sPort;
+  int bckPin;
+  int wsPin;
+  int dataPin;
+  audioRender_t render;  // Called from the render task once per analysed frame
+  void * renderArg;
+} audioReactive_config_t;
+
+typedef struct {
+  uint32_t frames;
+  uint32_t overruns;       // Captured frames dropped because analysis fell behind
+  uint32_t fftUsMax;       // Worst-case window + FFT + band grouping time
+  uint32_t renderUsMax;    // Worst-case render callback time
+  uint32_t frameBudgetUs;  // Time between captured frames
+} audioReactive_stats_t;
+
+extern int audioReactive_init(const audioReactive_config_t * config);
+extern void audioReactive_getStats(audioReactive_stats_t * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUDIO_REACTIVE_H */
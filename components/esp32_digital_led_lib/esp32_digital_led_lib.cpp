@@ -39,14 +39,18 @@ extern "C" {
   #include "driver/gpio.h"
   #include "driver/rmt.h"
   #include "driver/periph_ctrl.h"
+  #include "esp_heap_caps.h"
   #include "freertos/semphr.h"
+  #include "sdkconfig.h"
   #include "soc/rmt_struct.h"
 #elif defined(ESP_PLATFORM)
   #include <esp_intr.h>
   #include <driver/gpio.h>
   #include <driver/rmt.h>
+  #include <esp_heap_caps.h>
   #include <freertos/FreeRTOS.h>
   #include <freertos/semphr.h>
+  #include <sdkconfig.h>
   #include <soc/dport_reg.h>
   #include <soc/gpio_sig_map.h>
   #include <soc/rmt_struct.h>
@@ -63,9 +67,12 @@ extern char * digitalLeds_debugBuffer;
 extern int digitalLeds_debugBufferSz;
 #endif
 
-static DRAM_ATTR const uint16_t MAX_PULSES = 32;  // A channel has a 64 "pulse" buffer - we use half per pass
+static DRAM_ATTR const uint16_t MAX_PULSES = 32;  // Each memory block has a 64 "pulse" buffer - we use half per pass
+static DRAM_ATTR const int      RMT_CHANNELS = 8;  // Each channel owns one memory block by default
 static DRAM_ATTR const uint16_t DIVIDER    =  4;  // 8 still seems to work, but timings become marginal
 static DRAM_ATTR const double   RMT_DURATION_NS = 12.5;  // Minimum time of a single RMT duration based on clock ns
+static DRAM_ATTR const uint32_t STAGE_PIXELS = 64;  // Pixels per staging window; two are kept (palette/streamed strands)
+static DRAM_ATTR const uint32_t TX_TIMEOUT_SLACK_MS = 10;  // Added to twice the nominal frame time
 
 // LUT for mapping bits in RMT.int_<op>.ch<n>_tx_thr_event
 static DRAM_ATTR const uint32_t tx_thr_event_offsets [] = {
@@ -103,8 +110,20 @@ typedef union {
 
 typedef struct {
   uint8_t * buf_data;
-  uint16_t buf_pos, buf_len, buf_half, buf_isDirty;
+  volatile uint32_t buf_pos;  // Advanced by the refill, read by fillStageAhead() in task context
+  uint32_t buf_len;
+  uint32_t stage_bytes;  // Bytes per staging window, or buf_len when the whole frame is packed
+  uint32_t stage_count;  // Windows in the frame
+  volatile uint32_t stage_packed;  // Windows packed so far; window n lives in half n % 2 of buf_data
+  portMUX_TYPE stage_mux;  // Held while a window is claimed and packed, by the task or the refill
+  uint16_t buf_half, buf_isDirty;
+  uint16_t half_pulses;  // Pulses refilled per pass: half of the channel's memory blocks
+  volatile rmt_item32_t * rmt_mem;
   xSemaphoreHandle sem;
+  TickType_t tx_timeout;
+  volatile bool tx_done;  // Set by the interrupt handler on tx_end
+  bool tx_faulted;  // Last transmit missed its deadline
+  digitalLeds_stats_t stats;
   rmtPulsePair pulsePairMap[2];
 } digitalLeds_stateData;
 
@@ -114,7 +133,12 @@ static int localStrandCnt = 0;
 static intr_handle_t rmt_intr_handle = nullptr;
 
 // Forward declarations of local functions
-static void copyToRmtBlock_half(strand_t * pStrand);
+static int rmtMemBlocks(strand_t strands [], int numStrands, int channel);
+static void packPixels(strand_t * pStrand, int bytesPerPixel, uint32_t first, uint32_t count, uint8_t * dst);
+static void fillStage(strand_t * pStrand, uint32_t window);
+static void fillStageAhead(strand_t * pStrand);
+static void resetChannel(strand_t * pStrand);
+static bool copyToRmtBlock_half(strand_t * pStrand);
 static void handleInterrupt(void *arg);
 
 
@@ -127,10 +151,28 @@ int digitalLeds_initStrands(strand_t strands [], int numStrands)
 
   localStrands = strands;
   localStrandCnt = numStrands;
-  if (localStrandCnt < 1 || localStrandCnt > 8) {
+  if (localStrandCnt < 1 || localStrandCnt > RMT_CHANNELS) {
     return -1;
   }
 
+  // Channels are the caller's, unless every strand asks for one to be
+  // assigned: then they are spread evenly so each gets an equal share of
+  // the 8 memory blocks
+  int autoChannels = 0;
+  for (int i = 0; i < localStrandCnt; i++) {
+    autoChannels += (strands[i].rmtChannel == DIGITALLEDS_AUTO_CHANNEL);
+  }
+  if (autoChannels == localStrandCnt) {
+    for (int i = 0; i < localStrandCnt; i++) {
+      strands[i].rmtChannel = i * RMT_CHANNELS / localStrandCnt;
+    }
+  }
+  for (int i = 0; i < localStrandCnt; i++) {
+    if (rmtMemBlocks(strands, numStrands, strands[i].rmtChannel) < 1) {
+      return -1;
+    }
+  }
+
   DPORT_SET_PERI_REG_MASK(DPORT_PERIP_CLK_EN_REG, DPORT_RMT_CLK_EN);
   DPORT_CLEAR_PERI_REG_MASK(DPORT_PERIP_RST_EN_REG, DPORT_RMT_RST);
 
@@ -141,9 +183,32 @@ int digitalLeds_initStrands(strand_t strands [], int numStrands)
     strand_t * pStrand = &localStrands[i];
     ledParams_t ledParams = ledParamsAll[pStrand->ledType];
 
-    pStrand->pixels = static_cast<pixelColor_t*>(malloc(pStrand->numPixels * sizeof(pixelColor_t)));
-    if (pStrand->pixels == nullptr) {
-      return -1;
+    // Claim the unused memory blocks after this channel
+    int memBlocks = rmtMemBlocks(strands, numStrands, pStrand->rmtChannel);
+
+    // Streamed strands keep their frame in PSRAM; everything else lives in internal RAM
+    uint32_t frameCaps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    #if CONFIG_SPIRAM_SUPPORT
+      if (pStrand->streamFromPsram) {
+        frameCaps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+      }
+    #endif
+    uint32_t numPixels = pStrand->numPixels;
+
+    if (pStrand->paletteMode) {
+      // One index byte per pixel; expanded through the palette while staging
+      pStrand->pixels = nullptr;
+      pStrand->pixelIdx = static_cast<uint8_t*>(heap_caps_malloc(numPixels, frameCaps));
+      pStrand->palette = static_cast<pixelColor_t*>(malloc(DIGITALLEDS_PALETTE_SIZE * sizeof(pixelColor_t)));
+      if (pStrand->pixelIdx == nullptr || pStrand->palette == nullptr) {
+        return -1;
+      }
+    }
+    else {
+      pStrand->pixels = static_cast<pixelColor_t*>(heap_caps_malloc(numPixels * sizeof(pixelColor_t), frameCaps));
+      if (pStrand->pixels == nullptr) {
+        return -1;
+      }
     }
 
     pStrand->_stateVars = static_cast<digitalLeds_stateData*>(malloc(sizeof(digitalLeds_stateData)));
@@ -152,8 +217,21 @@ int digitalLeds_initStrands(strand_t strands [], int numStrands)
     }
     digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
 
-    pState->buf_len = (pStrand->numPixels * ledParams.bytesPerPixel);
-    pState->buf_data = static_cast<uint8_t*>(malloc(pState->buf_len));
+    pState->buf_len = (numPixels * ledParams.bytesPerPixel);
+    if (pStrand->paletteMode || pStrand->streamFromPsram) {
+      // Only two windows of the packed frame are kept: one is sent while the
+      // other is packed
+      uint32_t stagePixels = (numPixels < 2 * STAGE_PIXELS) ? numPixels : 2 * STAGE_PIXELS;
+      pState->stage_bytes = STAGE_PIXELS * ledParams.bytesPerPixel;
+      pState->buf_data = static_cast<uint8_t*>(
+        heap_caps_malloc(stagePixels * ledParams.bytesPerPixel, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    }
+    else {
+      pState->stage_bytes = pState->buf_len;
+      pState->buf_data = static_cast<uint8_t*>(malloc(pState->buf_len));
+    }
+    pState->stage_count = (pState->buf_len + pState->stage_bytes - 1) / pState->stage_bytes;
+    vPortCPUInitializeMutex(&pState->stage_mux);
     if (pState->buf_data == nullptr) {
       return -1;
     }
@@ -164,7 +242,11 @@ int digitalLeds_initStrands(strand_t strands [], int numStrands)
       static_cast<gpio_num_t>(pStrand->gpioNum));
   
     RMT.conf_ch[pStrand->rmtChannel].conf0.div_cnt = DIVIDER;
-    RMT.conf_ch[pStrand->rmtChannel].conf0.mem_size = 1;
+    // More memory blocks mean fewer refill interrupts per frame, each
+    // tolerating more latency
+    pState->half_pulses = memBlocks * MAX_PULSES;
+    pState->rmt_mem = &RMTMEM.chan[pStrand->rmtChannel].data32[0];
+    RMT.conf_ch[pStrand->rmtChannel].conf0.mem_size = memBlocks;
     RMT.conf_ch[pStrand->rmtChannel].conf0.carrier_en = 0;
     RMT.conf_ch[pStrand->rmtChannel].conf0.carrier_out_lv = 1;
     RMT.conf_ch[pStrand->rmtChannel].conf0.mem_pd = 0;
@@ -176,7 +258,7 @@ int digitalLeds_initStrands(strand_t strands [], int numStrands)
     RMT.conf_ch[pStrand->rmtChannel].conf1.idle_out_en = 1;
     RMT.conf_ch[pStrand->rmtChannel].conf1.idle_out_lv = 0;
   
-    RMT.tx_lim_ch[pStrand->rmtChannel].limit = MAX_PULSES;
+    RMT.tx_lim_ch[pStrand->rmtChannel].limit = pState->half_pulses;
   
     // RMT config for transmitting a '0' bit val to this LED strand
     pState->pulsePairMap[0].level0 = 1;
@@ -190,6 +272,22 @@ int digitalLeds_initStrands(strand_t strands [], int numStrands)
     pState->pulsePairMap[1].duration0 = ledParams.T1H / (RMT_DURATION_NS * DIVIDER);
     pState->pulsePairMap[1].duration1 = ledParams.T1L / (RMT_DURATION_NS * DIVIDER);
 
+    // Deadline for a whole frame: twice the nominal time at the slower bit
+    // timing, plus slack for scheduling and refill latency
+    uint32_t bitNs = ledParams.T0H + ledParams.T0L;
+    if (ledParams.T1H + ledParams.T1L > bitNs) {
+      bitNs = ledParams.T1H + ledParams.T1L;
+    }
+    uint64_t frameNs = static_cast<uint64_t>(pState->buf_len) * 8 * bitNs + ledParams.TRS;
+    pState->tx_timeout = pdMS_TO_TICKS(2 * frameNs / 1000000 + TX_TIMEOUT_SLACK_MS) + 1;
+    pState->tx_faulted = false;
+    memset(&pState->stats, 0, sizeof(pState->stats));
+
+    pState->sem = xSemaphoreCreateBinary();
+    if (pState->sem == nullptr) {
+      return -1;
+    }
+
     RMT.int_ena.val |= tx_thr_event_offsets[pStrand->rmtChannel];  // RMT.int_ena.ch<n>_tx_thr_event = 1;
     RMT.int_ena.val |= tx_end_offsets[pStrand->rmtChannel];  // RMT.int_ena.ch<n>_tx_end = 1;
   }
@@ -206,7 +304,13 @@ int digitalLeds_initStrands(strand_t strands [], int numStrands)
 
 void digitalLeds_resetPixels(strand_t * pStrand)
 {
-  memset(pStrand->pixels, 0, pStrand->numPixels * sizeof(pixelColor_t));
+  if (pStrand->paletteMode) {
+    memset(pStrand->pixelIdx, 0, pStrand->numPixels);
+    memset(pStrand->palette, 0, DIGITALLEDS_PALETTE_SIZE * sizeof(pixelColor_t));
+  }
+  else {
+    memset(pStrand->pixels, 0, static_cast<uint32_t>(pStrand->numPixels) * sizeof(pixelColor_t));
+  }
   digitalLeds_updatePixels(pStrand);
 }
 
@@ -215,31 +319,20 @@ int IRAM_ATTR digitalLeds_updatePixels(strand_t * pStrand)
   digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
   ledParams_t ledParams = ledParamsAll[pStrand->ledType];
 
-  // Pack pixels into transmission buffer
-  if (ledParams.bytesPerPixel == 3) {
-    for (uint16_t i = 0; i < pStrand->numPixels; i++) {
-      // Color order is translated from RGB to GRB
-      pState->buf_data[0 + i * 3] = pStrand->pixels[i].g;
-      pState->buf_data[1 + i * 3] = pStrand->pixels[i].r;
-      pState->buf_data[2 + i * 3] = pStrand->pixels[i].b;
-    }
-  }
-  else if (ledParams.bytesPerPixel == 4) {
-    for (uint16_t i = 0; i < pStrand->numPixels; i++) {
-      // Color order is translated from RGBW to GRBW
-      pState->buf_data[0 + i * 4] = pStrand->pixels[i].g;
-      pState->buf_data[1 + i * 4] = pStrand->pixels[i].r;
-      pState->buf_data[2 + i * 4] = pStrand->pixels[i].b;
-      pState->buf_data[3 + i * 4] = pStrand->pixels[i].w;
-    }    
-  }
-  else {
+  if (ledParams.bytesPerPixel != 3 && ledParams.bytesPerPixel != 4) {
+    pState->stats.droppedFrames++;
     return -1;
   }
 
   pState->buf_pos = 0;
   pState->buf_half = 0;
 
+  // Pack pixels into transmission buffer. Windowed strands get their first
+  // two windows now and the rest while the frame is sent, so palette
+  // animations only need to rewrite pStrand->palette between updates.
+  pState->stage_packed = 0;
+  fillStageAhead(pStrand);
+
   copyToRmtBlock_half(pStrand);
 
   if (pState->buf_pos < pState->buf_len) {
@@ -251,62 +344,225 @@ int IRAM_ATTR digitalLeds_updatePixels(strand_t * pStrand)
     copyToRmtBlock_half(pStrand);
   }
 
-  pState->sem = xSemaphoreCreateBinary();
+  xSemaphoreTake(pState->sem, 0);  // Discard a tx_end left over from a timed-out frame
+
+  pState->tx_done = false;
+  TickType_t txStart = xTaskGetTickCount();
 
   RMT.conf_ch[pStrand->rmtChannel].conf1.mem_rd_rst = 1;
+  RMT.int_clr.val = tx_end_offsets[pStrand->rmtChannel];  // Drop a tx_end latched since, before it can end this frame
   RMT.conf_ch[pStrand->rmtChannel].conf1.tx_start = 1;
 
-  xSemaphoreTake(pState->sem, portMAX_DELAY);
-  vSemaphoreDelete(pState->sem);
-  pState->sem = nullptr;
+  // The handler wakes us on tx_end, and on windowed strands each time the
+  // refill has moved on to the next window, so the freed one can be packed
+  while (true) {
+    TickType_t elapsed = xTaskGetTickCount() - txStart;
+    if (elapsed >= pState->tx_timeout || xSemaphoreTake(pState->sem, pState->tx_timeout - elapsed) != pdTRUE) {
+      // tx_end never arrived: give up on this frame and reset the channel so
+      // the caller is never blocked for longer than tx_timeout
+      resetChannel(pStrand);
+      pState->tx_faulted = true;
+      pState->stats.timeouts++;
+      pState->stats.droppedFrames++;
+      return -1;
+    }
+    if (pState->tx_done) {
+      break;
+    }
+    fillStageAhead(pStrand);
+  }
+
+  if (pState->tx_faulted) {
+    pState->tx_faulted = false;
+    pState->stats.recoveries++;
+  }
+  pState->stats.frames++;
 
   return 0;
 }
 
-static IRAM_ATTR void copyToRmtBlock_half(strand_t * pStrand)
+void digitalLeds_getStats(strand_t * pStrand, digitalLeds_stats_t * stats)
+{
+  digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
+  *stats = pState->stats;
+}
+
+static int rmtMemBlocks(strand_t strands [], int numStrands, int channel)
+{
+  // A channel with mem_size n uses its own block and the n - 1 blocks of the
+  // channels above it, so it may grow up to the next configured channel.
+  // Returns 0 for an invalid or duplicated channel.
+  if (channel < 0 || channel >= RMT_CHANNELS) {
+    return 0;
+  }
+
+  int next = RMT_CHANNELS;
+  int uses = 0;
+  for (int i = 0; i < numStrands; i++) {
+    int other = strands[i].rmtChannel;
+    if (other == channel) {
+      uses++;
+    }
+    else if (other > channel && other < next) {
+      next = other;
+    }
+  }
+
+  return (uses == 1) ? next - channel : 0;
+}
+
+static void resetChannel(strand_t * pStrand)
+{
+  digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
+  int ch = pStrand->rmtChannel;
+  uint32_t intMask = tx_thr_event_offsets[ch] | tx_end_offsets[ch];
+
+  // Keep the interrupt handler away from the channel while it is stopped
+  RMT.int_ena.val &= ~intMask;
+
+  // Clearing tx_start does not stop a transmit under way, and mem_rd_rst
+  // sends it back to item 0; with the memory cleared it ends there instead
+  // of replaying stale pulses and raising a late tx_end
+  RMT.conf_ch[ch].conf1.tx_start = 0;
+  for (uint32_t i = 0; i < 2u * pState->half_pulses; i++) {
+    pState->rmt_mem[i].val = 0;
+  }
+  RMT.conf_ch[ch].conf1.mem_rd_rst = 1;
+  RMT.conf_ch[ch].conf1.mem_rd_rst = 0;
+  RMT.int_clr.val = intMask;
+
+  pState->buf_pos = pState->buf_len;
+  pState->buf_isDirty = 1;  // Make the next refill clear stale pulses
+  xSemaphoreTake(pState->sem, 0);
+
+  RMT.int_ena.val |= intMask;
+}
+
+static IRAM_ATTR void packPixels(strand_t * pStrand, int bytesPerPixel, uint32_t first, uint32_t count, uint8_t * dst)
+{
+  if (bytesPerPixel == 3) {
+    for (uint32_t i = first; i < first + count; i++) {
+      pixelColor_t color = pStrand->paletteMode ? pStrand->palette[pStrand->pixelIdx[i]] : pStrand->pixels[i];
+      // Color order is translated from RGB to GRB
+      *dst++ = color.g;
+      *dst++ = color.r;
+      *dst++ = color.b;
+    }
+  }
+  else {
+    for (uint32_t i = first; i < first + count; i++) {
+      pixelColor_t color = pStrand->paletteMode ? pStrand->palette[pStrand->pixelIdx[i]] : pStrand->pixels[i];
+      // Color order is translated from RGBW to GRBW
+      *dst++ = color.g;
+      *dst++ = color.r;
+      *dst++ = color.b;
+      *dst++ = color.w;
+    }
+  }
+}
+
+static IRAM_ATTR void fillStage(strand_t * pStrand, uint32_t window)
+{
+  // Pack one window of pixels into its half of the internal-RAM staging buffer
+
+  digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
+  int bytesPerPixel = ledParamsAll[pStrand->ledType].bytesPerPixel;
+
+  uint32_t windowPixels = pState->stage_bytes / bytesPerPixel;
+  uint32_t first = window * windowPixels;
+  uint32_t count = pStrand->numPixels - first;
+  if (count > windowPixels)
+    count = windowPixels;
+
+  packPixels(pStrand, bytesPerPixel, first, count, pState->buf_data + (window % 2) * pState->stage_bytes);
+}
+
+static void fillStageAhead(strand_t * pStrand)
+{
+  // Pack every window whose half of the staging buffer the refill has left
+  // behind. Runs in task context, possibly on the other core from the
+  // refill, so each window is checked and packed under stage_mux: the
+  // refill either finds it packed or waits, and a window the refill has
+  // already packed itself is never written again. The lock is held for one
+  // window at a time.
+
+  digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
+
+  while (true) {
+    portENTER_CRITICAL(&pState->stage_mux);
+    uint32_t window = pState->stage_packed;
+    // Its half is free once the refill has moved on to the window before it
+    bool ready = window < pState->stage_count &&
+                 (window < 2 || pState->buf_pos >= (window - 1) * pState->stage_bytes);
+    if (ready) {
+      fillStage(pStrand, window);
+      pState->stage_packed = window + 1;
+    }
+    portEXIT_CRITICAL(&pState->stage_mux);
+    if (!ready) {
+      break;
+    }
+  }
+}
+
+static IRAM_ATTR bool copyToRmtBlock_half(strand_t * pStrand)
 {
   // This fills half an RMT block
   // When wraparound is happening, we want to keep the inactive half of the RMT block filled
+  // Returns true when a staging window was used up and can be packed again
 
   digitalLeds_stateData * pState = static_cast<digitalLeds_stateData*>(pStrand->_stateVars);
   ledParams_t ledParams = ledParamsAll[pStrand->ledType];
 
-  uint16_t i, j, offset, len, byteval;
+  uint32_t i, j, offset, len, byteval;
 
-  offset = pState->buf_half * MAX_PULSES;
+  offset = pState->buf_half * pState->half_pulses;
   pState->buf_half = !pState->buf_half;
 
   len = pState->buf_len - pState->buf_pos;
-  if (len > (MAX_PULSES / 8))
-    len = (MAX_PULSES / 8);
+  if (len > (pState->half_pulses / 8u))
+    len = (pState->half_pulses / 8u);
 
   if (!len) {
     if (!pState->buf_isDirty) {
-      return;
+      return false;
     }
     // Clear the channel's data block and return
-    for (i = 0; i < MAX_PULSES; i++) {
-      RMTMEM.chan[pStrand->rmtChannel].data32[i + offset].val = 0;
+    for (i = 0; i < pState->half_pulses; i++) {
+      pState->rmt_mem[i + offset].val = 0;
     }
     pState->buf_isDirty = 0;
-    return;
+    return false;
   }
   pState->buf_isDirty = 1;
 
   for (i = 0; i < len; i++) {
-    byteval = pState->buf_data[i + pState->buf_pos];
+    uint32_t pos = i + pState->buf_pos;
+    uint32_t window = pos / pState->stage_bytes;
+    if (window >= pState->stage_packed) {
+      // The task fell behind: pack the window here rather than send stale
+      // bytes, unless the task finishes it while we wait for the lock
+      portENTER_CRITICAL_ISR(&pState->stage_mux);
+      if (window >= pState->stage_packed) {
+        fillStage(pStrand, window);
+        pState->stage_packed = window + 1;
+        pState->stats.stageStalls++;
+      }
+      portEXIT_CRITICAL_ISR(&pState->stage_mux);
+    }
+    byteval = pState->buf_data[(window % 2) * pState->stage_bytes + pos % pState->stage_bytes];
 
     #if DEBUG_ESP32_DIGITAL_LED_LIB
       snprintf(digitalLeds_debugBuffer, digitalLeds_debugBufferSz,
                "%s%d(", digitalLeds_debugBuffer, byteval);
     #endif
 
-    // Shift bits out, MSB first, setting RMTMEM.chan[n].data32[x] to
+    // Shift bits out, MSB first, setting the channel's RMT memory to
     // the rmtPulsePair value corresponding to the buffered bit value
     for (j = 0; j < 8; j++, byteval <<= 1) {
       int bitval = (byteval >> 7) & 0x01;
       int data32_idx = i * 8 + offset + j;
-      RMTMEM.chan[pStrand->rmtChannel].data32[data32_idx].val = pState->pulsePairMap[bitval].val;
+      pState->rmt_mem[data32_idx].val = pState->pulsePairMap[bitval].val;
       #if DEBUG_ESP32_DIGITAL_LED_LIB
         snprintf(digitalLeds_debugBuffer, digitalLeds_debugBufferSz,
                  "%s%d", digitalLeds_debugBuffer, bitval);
@@ -319,7 +575,7 @@ static IRAM_ATTR void copyToRmtBlock_half(strand_t * pStrand)
 
     // Handle the reset bit by stretching duration1 for the final bit in the stream
     if (i + pState->buf_pos == pState->buf_len - 1) {
-      RMTMEM.chan[pStrand->rmtChannel].data32[i * 8 + offset + 7].duration1 =
+      pState->rmt_mem[i * 8 + offset + 7].duration1 =
         ledParams.TRS / (RMT_DURATION_NS * DIVIDER);
       #if DEBUG_ESP32_DIGITAL_LED_LIB
         snprintf(digitalLeds_debugBuffer, digitalLeds_debugBufferSz,
@@ -329,10 +585,11 @@ static IRAM_ATTR void copyToRmtBlock_half(strand_t * pStrand)
   }
 
   // Clear the remainder of the channel's data not set above
-  for (i *= 8; i < MAX_PULSES; i++) {
-    RMTMEM.chan[pStrand->rmtChannel].data32[i + offset].val = 0;
+  for (i *= 8; i < pState->half_pulses; i++) {
+    pState->rmt_mem[i + offset].val = 0;
   }
   
+  uint32_t window = pState->buf_pos / pState->stage_bytes;
   pState->buf_pos += len;
 
   #if DEBUG_ESP32_DIGITAL_LED_LIB
@@ -340,7 +597,7 @@ static IRAM_ATTR void copyToRmtBlock_half(strand_t * pStrand)
              "%s ", digitalLeds_debugBuffer);
   #endif
 
-  return;
+  return pState->buf_pos / pState->stage_bytes != window && pState->stage_packed < pState->stage_count;
 }
 
 static IRAM_ATTR void handleInterrupt(void *arg)
@@ -358,11 +615,18 @@ static IRAM_ATTR void handleInterrupt(void *arg)
 
     if (RMT.int_st.val & tx_thr_event_offsets[pStrand->rmtChannel])
     {  // tests RMT.int_st.ch<n>_tx_thr_event
-      copyToRmtBlock_half(pStrand);
+      if (copyToRmtBlock_half(pStrand) && pState->sem) {
+        xSemaphoreGiveFromISR(pState->sem, &xHigherPriorityTaskWoken);  // Let the task pack the next window
+      }
       RMT.int_clr.val |= tx_thr_event_offsets[pStrand->rmtChannel];  // set RMT.int_clr.ch<n>_tx_thr_event
+      if (xHigherPriorityTaskWoken == pdTRUE)
+      {
+          portYIELD_FROM_ISR();
+      }
     }
     else if (RMT.int_st.val & tx_end_offsets[pStrand->rmtChannel] && pState->sem)
     {  // tests RMT.int_st.ch<n>_tx_end and semaphore
+      pState->tx_done = true;
       xSemaphoreGiveFromISR(pState->sem, &xHigherPriorityTaskWoken);
       RMT.int_clr.val |= tx_end_offsets[pStrand->rmtChannel];  // set RMT.int_clr.ch<n>_tx_end 
       if (xHigherPriorityTaskWoken == pdTRUE)
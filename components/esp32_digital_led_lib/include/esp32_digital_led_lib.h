@@ -65,13 +65,22 @@ inline pixelColor_t pixelFromRGBW(uint8_t r, uint8_t g, uint8_t b, uint8_t w)
   return v;
 }
 
+#define DIGITALLEDS_PALETTE_SIZE 256
+#define DIGITALLEDS_AUTO_CHANNEL -1  // Set on every strand to have the channels spaced evenly
+
 typedef struct {
-  int rmtChannel;
+  int rmtChannel;          // Unused channels above this one lend their RMT memory, so space strands
+                           // out; DIGITALLEDS_AUTO_CHANNEL on every strand spaces them evenly
   int gpioNum;
   int ledType;
   int brightLimit;
   int numPixels;
   pixelColor_t * pixels;
+  int paletteMode;         // If set, pixelIdx/palette are allocated instead of pixels
+  uint8_t * pixelIdx;      // One palette index per pixel (paletteMode only)
+  pixelColor_t * palette;  // DIGITALLEDS_PALETTE_SIZE entries (paletteMode only)
+  int streamFromPsram;     // If set, the frame lives in PSRAM and is packed window by window while
+                           // sending; without CONFIG_SPIRAM_SUPPORT it stays in internal RAM
   void * _stateVars;
 } strand_t;
 
@@ -84,6 +93,14 @@ typedef struct {
   uint32_t TRS;
 } ledParams_t;
 
+typedef struct {
+  uint32_t frames;         // Frames whose transmit completed
+  uint32_t timeouts;       // Transmits that missed their deadline and reset the channel
+  uint32_t recoveries;     // Frames completed again after one or more timeouts
+  uint32_t droppedFrames;  // Frames not transmitted, including timeouts
+  uint32_t stageStalls;    // Windows the refill interrupt had to pack because the task fell behind
+} digitalLeds_stats_t;
+
 enum led_types {
   LED_WS2812_V1,
   LED_WS2812B_V1,
@@ -96,7 +113,7 @@ enum led_types {
   LED_SK6812W_V1,
 };
 
-const ledParams_t ledParamsAll[] = {  // Still must match order of `led_types`
+static const ledParams_t ledParamsAll[] = {  // Still must match order of `led_types`
   [LED_WS2812_V1]  = { .bytesPerPixel = 3, .T0H = 350, .T1H = 700, .T0L = 800, .T1L = 600, .TRS =  50000},
   [LED_WS2812B_V1] = { .bytesPerPixel = 3, .T0H = 350, .T1H = 900, .T0L = 900, .T1L = 350, .TRS =  50000}, // Older datasheet
   [LED_WS2812B_V2] = { .bytesPerPixel = 3, .T0H = 400, .T1H = 850, .T0L = 850, .T1L = 400, .TRS =  50000}, // 2016 datasheet
@@ -111,6 +128,7 @@ const ledParams_t ledParamsAll[] = {  // Still must match order of `led_types`
 extern int digitalLeds_initStrands(strand_t strands [], int numStrands);
 extern int digitalLeds_updatePixels(strand_t * strand);
 extern void digitalLeds_resetPixels(strand_t * pStrand);
+extern void digitalLeds_getStats(strand_t * pStrand, digitalLeds_stats_t * stats);
 
 #ifdef __cplusplus
 }
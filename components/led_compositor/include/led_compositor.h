@@ -0,0 +1,70 @@
+/*
+ * Layered compositor for LED strands
+ *
+ * Layers are stacked bottom to top and blended with 8-bit fixed-point math
+ * into strand->pixels in a single pass. A layer is either a solid color or a
+ * per-pixel buffer. compositor_render() does nothing when no layer changed,
+ * and when only the topmost layer changed it reuses a cached blend of the
+ * layers below it. If the strand update fails the layers stay dirty, so the
+ * next render transmits the frame again.
+ */
+
+#ifndef LED_COMPOSITOR_H
+#define LED_COMPOSITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "esp32_digital_led_lib.h"
+
+#define COMPOSITOR_MAX_LAYERS 4
+
+enum compositor_layers {
+  LAYER_BASE,        // User color or effect
+  LAYER_TRANSITION,  // Cross-fades between base states
+  LAYER_OVERLAY,     // Identify and notification flashes
+};
+
+enum blend_modes {
+  BLEND_NORMAL,      // Layer replaces what is below, scaled by alpha
+  BLEND_ADD,
+  BLEND_MULTIPLY,
+  BLEND_MAX,
+};
+
+typedef struct {
+  int enabled;
+  int blendMode;
+  uint8_t alpha;
+  int usePixels;           // Per-pixel content in pixels[], else the solid color
+  pixelColor_t color;
+  pixelColor_t * pixels;   // Allocated on first compositor_lockLayer()
+} compositorLayer_t;
+
+typedef struct {
+  strand_t * strand;
+  compositorLayer_t layers[COMPOSITOR_MAX_LAYERS];
+  uint32_t dirty;          // Bit per layer changed since the last sent frame
+  pixelColor_t * cache;    // Blend of the layers below cacheTop
+  int cacheTop;            // -1 when the cache is invalid
+  uint32_t blendUs;        // Duration of the last blend pass
+  SemaphoreHandle_t lock;
+} compositor_t;
+
+extern int compositor_init(compositor_t * comp, strand_t * strand);
+extern void compositor_setColor(compositor_t * comp, int layer, pixelColor_t color);
+extern void compositor_setAlpha(compositor_t * comp, int layer, uint8_t alpha, int blendMode);
+extern void compositor_enable(compositor_t * comp, int layer, int enabled);
+extern pixelColor_t * compositor_lockLayer(compositor_t * comp, int layer);
+extern void compositor_unlockLayer(compositor_t * comp, int layer);
+extern int compositor_render(compositor_t * comp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_COMPOSITOR_H */
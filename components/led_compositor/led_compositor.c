@@ -0,0 +1,192 @@
+/*
+ * Layered compositor for LED strands
+ */
+
+#include "led_compositor.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_timer.h>
+
+static inline uint8_t div255(uint32_t x)
+{
+  // x / 255, exact for x <= 255 * 255
+  return (x + 1 + (x >> 8)) >> 8;
+}
+
+static inline uint8_t blendChannel(uint8_t dst, uint8_t src, uint8_t alpha, int blendMode)
+{
+  uint32_t target;
+  switch (blendMode) {
+    case BLEND_ADD:      target = dst + src; if (target > 255) target = 255; break;
+    case BLEND_MULTIPLY: target = div255(dst * src); break;
+    case BLEND_MAX:      target = (dst > src) ? dst : src; break;
+    default:             target = src; break;
+  }
+  return div255(target * alpha + dst * (255 - alpha));
+}
+
+static inline pixelColor_t blendPixel(pixelColor_t dst, pixelColor_t src, uint8_t alpha, int blendMode)
+{
+  pixelColor_t out;
+  out.r = blendChannel(dst.r, src.r, alpha, blendMode);
+  out.g = blendChannel(dst.g, src.g, alpha, blendMode);
+  out.b = blendChannel(dst.b, src.b, alpha, blendMode);
+  out.w = blendChannel(dst.w, src.w, alpha, blendMode);
+  return out;
+}
+
+static inline pixelColor_t layerPixel(const compositorLayer_t * layer, uint32_t i)
+{
+  return layer->usePixels ? layer->pixels[i] : layer->color;
+}
+
+int compositor_init(compositor_t * comp, strand_t * strand)
+{
+  if (strand->pixels == NULL) {
+    return -1;
+  }
+
+  memset(comp, 0, sizeof(*comp));
+  comp->strand = strand;
+  comp->cacheTop = -1;
+  for (int i = 0; i < COMPOSITOR_MAX_LAYERS; i++) {
+    comp->layers[i].alpha = 255;
+    comp->layers[i].blendMode = BLEND_NORMAL;
+  }
+
+  comp->cache = (pixelColor_t *)malloc(strand->numPixels * sizeof(pixelColor_t));
+  comp->lock = xSemaphoreCreateMutex();
+  if (comp->cache == NULL || comp->lock == NULL) {
+    return -1;
+  }
+  return 0;
+}
+
+void compositor_setColor(compositor_t * comp, int layer, pixelColor_t color)
+{
+  xSemaphoreTake(comp->lock, portMAX_DELAY);
+  comp->layers[layer].color = color;
+  comp->layers[layer].usePixels = 0;
+  comp->dirty |= 1 << layer;
+  xSemaphoreGive(comp->lock);
+}
+
+void compositor_setAlpha(compositor_t * comp, int layer, uint8_t alpha, int blendMode)
+{
+  xSemaphoreTake(comp->lock, portMAX_DELAY);
+  comp->layers[layer].alpha = alpha;
+  comp->layers[layer].blendMode = blendMode;
+  comp->dirty |= 1 << layer;
+  xSemaphoreGive(comp->lock);
+}
+
+void compositor_enable(compositor_t * comp, int layer, int enabled)
+{
+  xSemaphoreTake(comp->lock, portMAX_DELAY);
+  if (comp->layers[layer].enabled != enabled) {
+    comp->layers[layer].enabled = enabled;
+    comp->dirty |= 1 << layer;
+  }
+  xSemaphoreGive(comp->lock);
+}
+
+pixelColor_t * compositor_lockLayer(compositor_t * comp, int layer)
+{
+  // Returns the layer's pixel buffer with the compositor locked; the caller
+  // writes it and hands it back with compositor_unlockLayer()
+  xSemaphoreTake(comp->lock, portMAX_DELAY);
+  compositorLayer_t * pLayer = &comp->layers[layer];
+  if (pLayer->pixels == NULL) {
+    pLayer->pixels = (pixelColor_t *)calloc(comp->strand->numPixels, sizeof(pixelColor_t));
+    if (pLayer->pixels == NULL) {
+      xSemaphoreGive(comp->lock);
+      return NULL;
+    }
+  }
+  pLayer->usePixels = 1;
+  return pLayer->pixels;
+}
+
+void compositor_unlockLayer(compositor_t * comp, int layer)
+{
+  comp->dirty |= 1 << layer;
+  xSemaphoreGive(comp->lock);
+}
+
+int compositor_render(compositor_t * comp)
+{
+  xSemaphoreTake(comp->lock, portMAX_DELAY);
+  if (!comp->dirty) {
+    xSemaphoreGive(comp->lock);
+    return 0;
+  }
+
+  strand_t * pStrand = comp->strand;
+  uint32_t numPixels = pStrand->numPixels;
+  pixelColor_t * out = pStrand->pixels;
+  int64_t start = esp_timer_get_time();
+
+  int top = -1;
+  int allSolid = 1;
+  for (int l = 0; l < COMPOSITOR_MAX_LAYERS; l++) {
+    if (comp->layers[l].enabled) {
+      top = l;
+      allSolid &= !comp->layers[l].usePixels;
+    }
+  }
+
+  if (top < 0) {
+    memset(out, 0, numPixels * sizeof(pixelColor_t));
+  }
+  else if (allSolid) {
+    // Every pixel gets the same result: blend once and fill
+    pixelColor_t color = pixelFromRGBW(0, 0, 0, 0);
+    for (int l = 0; l <= top; l++) {
+      const compositorLayer_t * pLayer = &comp->layers[l];
+      if (pLayer->enabled) {
+        color = blendPixel(color, pLayer->color, pLayer->alpha, pLayer->blendMode);
+      }
+    }
+    for (uint32_t i = 0; i < numPixels; i++) {
+      out[i] = color;
+    }
+    comp->cacheTop = -1;
+  }
+  else {
+    // Layers below the top are only blended again when one of them changed
+    const compositorLayer_t * pTop = &comp->layers[top];
+    uint32_t belowMask = (1 << top) - 1;
+    if (comp->cacheTop == top && !(comp->dirty & belowMask)) {
+      for (uint32_t i = 0; i < numPixels; i++) {
+        out[i] = blendPixel(comp->cache[i], layerPixel(pTop, i), pTop->alpha, pTop->blendMode);
+      }
+    }
+    else {
+      for (uint32_t i = 0; i < numPixels; i++) {
+        pixelColor_t color = pixelFromRGBW(0, 0, 0, 0);
+        for (int l = 0; l < top; l++) {
+          const compositorLayer_t * pLayer = &comp->layers[l];
+          if (pLayer->enabled) {
+            color = blendPixel(color, layerPixel(pLayer, i), pLayer->alpha, pLayer->blendMode);
+          }
+        }
+        comp->cache[i] = color;
+        out[i] = blendPixel(color, layerPixel(pTop, i), pTop->alpha, pTop->blendMode);
+      }
+      comp->cacheTop = top;
+    }
+  }
+
+  comp->blendUs = esp_timer_get_time() - start;
+
+  // A frame that did not go out leaves the layers dirty, so the next render
+  // sends it again instead of returning early
+  int ret = digitalLeds_updatePixels(pStrand);
+  if (ret == 0) {
+    comp->dirty = 0;
+  }
+  xSemaphoreGive(comp->lock);
+  return ret;
+}
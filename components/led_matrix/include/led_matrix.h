@@ -0,0 +1,71 @@
+/*
+ * 2D layout mapping for LED matrices driven as a single strand
+ *
+ * A matrix is described by its tiles, the wiring inside each tile and a
+ * rotation. ledMatrix_init() turns that description into an (x, y) -> pixel
+ * index table once; drawing then happens in a row-major framebuffer that
+ * ledMatrix_show() remaps onto strand->pixels in a single pass.
+ */
+
+#ifndef LED_MATRIX_H
+#define LED_MATRIX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp32_digital_led_lib.h"
+
+enum matrix_wiring {
+  MATRIX_PROGRESSIVE,  // Every row starts on the left
+  MATRIX_SERPENTINE,   // Odd rows run right to left
+};
+
+enum matrix_rotation {
+  MATRIX_ROTATE_0,
+  MATRIX_ROTATE_90,    // Clockwise
+  MATRIX_ROTATE_180,
+  MATRIX_ROTATE_270,
+};
+
+typedef struct {
+  int tileWidth;        // Pixels per tile row
+  int tileHeight;
+  int tilesX;           // Tiles are chained row by row, starting top left
+  int tilesY;
+  int wiring;           // matrix_wiring inside each tile
+  int tileWiring;       // matrix_wiring of the tile chain itself
+  int rotation;         // matrix_rotation applied to the whole matrix
+} matrixLayout_t;
+
+typedef struct {
+  strand_t * strand;
+  int width;            // Logical size, after rotation
+  int height;
+  uint32_t * indexTable;   // width * height strand indices, row-major
+  pixelColor_t * frame;    // width * height pixels, row-major
+} ledMatrix_t;
+
+extern int ledMatrix_init(ledMatrix_t * matrix, strand_t * strand, const matrixLayout_t * layout);
+extern void ledMatrix_fill(ledMatrix_t * matrix, pixelColor_t color);
+extern void ledMatrix_blit(ledMatrix_t * matrix, int x, int y, int w, int h,
+                           const pixelColor_t * src, int srcStride);
+extern int ledMatrix_show(ledMatrix_t * matrix);
+
+// Copies the framebuffer onto strand->pixels without sending it
+extern void ledMatrix_remap(ledMatrix_t * matrix);
+
+// Strand index of logical pixel (x, y), computed without the index table
+extern uint32_t ledMatrix_mapXY(const matrixLayout_t * layout, int x, int y);
+
+static inline void ledMatrix_setPixel(ledMatrix_t * matrix, int x, int y, pixelColor_t color)
+{
+  matrix->frame[y * matrix->width + x] = color;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_MATRIX_H */
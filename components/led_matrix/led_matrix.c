@@ -0,0 +1,133 @@
+/*
+ * 2D layout mapping for LED matrices driven as a single strand
+ */
+
+#include "led_matrix.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t physicalIndex(const matrixLayout_t * layout, int px, int py)
+{
+  // Position on the unrotated panel -> position along the strand
+  int tx = px / layout->tileWidth;
+  int ty = py / layout->tileHeight;
+  int lx = px % layout->tileWidth;
+  int ly = py % layout->tileHeight;
+
+  if (layout->tileWiring == MATRIX_SERPENTINE && (ty & 1)) {
+    tx = layout->tilesX - 1 - tx;
+  }
+  if (layout->wiring == MATRIX_SERPENTINE && (ly & 1)) {
+    lx = layout->tileWidth - 1 - lx;
+  }
+
+  uint32_t tile = ty * layout->tilesX + tx;
+  return tile * layout->tileWidth * layout->tileHeight + ly * layout->tileWidth + lx;
+}
+
+uint32_t ledMatrix_mapXY(const matrixLayout_t * layout, int x, int y)
+{
+  int panelWidth = layout->tileWidth * layout->tilesX;
+  int panelHeight = layout->tileHeight * layout->tilesY;
+  int px, py;
+
+  switch (layout->rotation) {
+    case MATRIX_ROTATE_90:  px = y;                   py = panelHeight - 1 - x; break;
+    case MATRIX_ROTATE_180: px = panelWidth - 1 - x;  py = panelHeight - 1 - y; break;
+    case MATRIX_ROTATE_270: px = panelWidth - 1 - y;  py = x;                   break;
+    default:                px = x;                   py = y;                   break;
+  }
+  return physicalIndex(layout, px, py);
+}
+
+int ledMatrix_init(ledMatrix_t * matrix, strand_t * strand, const matrixLayout_t * layout)
+{
+  matrix->indexTable = NULL;
+  matrix->frame = NULL;
+
+  // Checked one by one: two negative factors would multiply to a valid size
+  if (layout->tileWidth <= 0 || layout->tileHeight <= 0 || layout->tilesX <= 0 || layout->tilesY <= 0 ||
+      strand->pixels == NULL) {
+    return -1;
+  }
+
+  // In 64 bits, so large tile counts cannot overflow into a size that fits;
+  // each side is at most numPixels before the product is taken
+  uint64_t maxPixels = (uint32_t)strand->numPixels;
+  uint64_t width64 = (uint64_t)layout->tileWidth * layout->tilesX;
+  uint64_t height64 = (uint64_t)layout->tileHeight * layout->tilesY;
+  if (width64 > maxPixels || height64 > maxPixels || width64 * height64 > maxPixels) {
+    return -1;
+  }
+  int panelWidth = (int)width64;
+  int panelHeight = (int)height64;
+  uint32_t numPixels = panelWidth * panelHeight;
+
+  int rotated = (layout->rotation == MATRIX_ROTATE_90 || layout->rotation == MATRIX_ROTATE_270);
+  matrix->strand = strand;
+  matrix->width = rotated ? panelHeight : panelWidth;
+  matrix->height = rotated ? panelWidth : panelHeight;
+
+  matrix->indexTable = (uint32_t *)malloc(numPixels * sizeof(uint32_t));
+  matrix->frame = (pixelColor_t *)calloc(numPixels, sizeof(pixelColor_t));
+  if (matrix->indexTable == NULL || matrix->frame == NULL) {
+    free(matrix->indexTable);
+    free(matrix->frame);
+    matrix->indexTable = NULL;
+    matrix->frame = NULL;
+    return -1;
+  }
+
+  for (int y = 0; y < matrix->height; y++) {
+    for (int x = 0; x < matrix->width; x++) {
+      matrix->indexTable[y * matrix->width + x] = ledMatrix_mapXY(layout, x, y);
+    }
+  }
+
+  return 0;
+}
+
+void ledMatrix_fill(ledMatrix_t * matrix, pixelColor_t color)
+{
+  uint32_t numPixels = matrix->width * matrix->height;
+  for (uint32_t i = 0; i < numPixels; i++) {
+    matrix->frame[i] = color;
+  }
+}
+
+void ledMatrix_blit(ledMatrix_t * matrix, int x, int y, int w, int h,
+                    const pixelColor_t * src, int srcStride)
+{
+  // Clip the source rectangle against the framebuffer, then copy whole rows
+  if (x < 0) { src -= x; w += x; x = 0; }
+  if (y < 0) { src -= y * srcStride; h += y; y = 0; }
+  if (x + w > matrix->width)  { w = matrix->width - x; }
+  if (y + h > matrix->height) { h = matrix->height - y; }
+  if (w <= 0 || h <= 0) {
+    return;
+  }
+
+  for (int row = 0; row < h; row++) {
+    memcpy(&matrix->frame[(y + row) * matrix->width + x], &src[row * srcStride], w * sizeof(pixelColor_t));
+  }
+}
+
+void ledMatrix_remap(ledMatrix_t * matrix)
+{
+  // One sequential pass over the framebuffer; only the writes are scattered
+  uint32_t numPixels = matrix->width * matrix->height;
+  const uint32_t * indexTable = matrix->indexTable;
+  const pixelColor_t * frame = matrix->frame;
+  pixelColor_t * pixels = matrix->strand->pixels;
+
+  for (uint32_t i = 0; i < numPixels; i++) {
+    pixels[indexTable[i]] = frame[i];
+  }
+}
+
+int ledMatrix_show(ledMatrix_t * matrix)
+{
+  ledMatrix_remap(matrix);
+  return digitalLeds_updatePixels(matrix->strand);
+}
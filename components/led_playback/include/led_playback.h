@@ -0,0 +1,88 @@
+/*
+ * Playback of pre-rendered animations stored in a flash data partition
+ *
+ * File layout (little endian), as written by tools/encode_frames.py:
+ *
+ *   header   magic "LEDF", u8 version, u8 bytesPerPixel (3 or 4), u16 fps,
+ *            u32 numPixels, u32 numFrames
+ *   frame    u8 type, u8 reserved[3], u32 payloadLen, payload
+ *
+ * FRAME_KEY payloads are runs of (u8 count, one pixel) covering the strand.
+ * FRAME_DELTA payloads patch the previous frame with (u8 skip, u8 count,
+ * count pixels) groups. Pixels are stored in RGB(W) order. The first frame
+ * must be a key frame. A payload with bytes left over, a key frame that does
+ * not cover numPixels or a delta that runs past it is rejected as corrupt.
+ *
+ * Between playback_start() and the return of playback_stop() the playback
+ * task owns the strand: it swaps strand->pixels between two buffers and
+ * calls digitalLeds_updatePixels() itself, without taking any lock. Nothing
+ * else may write the strand's pixels or update it in that time, including a
+ * compositor bound to the same strand.
+ */
+
+#ifndef LED_PLAYBACK_H
+#define LED_PLAYBACK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp32_digital_led_lib.h"
+
+#define PLAYBACK_MAGIC        0x4644454c  // "LEDF"
+#define PLAYBACK_VERSION      1
+// The frames partition uses an application-defined type; IDF reserves the
+// data subtypes it does not define
+#define PLAYBACK_PARTITION_TYPE    0x40
+#define PLAYBACK_PARTITION_SUBTYPE 0x00
+
+enum playback_frame_types {
+  FRAME_KEY,
+  FRAME_DELTA,
+};
+
+typedef struct __attribute__ ((packed)) {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t bytesPerPixel;
+  uint16_t fps;
+  uint32_t numPixels;
+  uint32_t numFrames;
+} playbackHeader_t;
+
+typedef struct __attribute__ ((packed)) {
+  uint8_t type;
+  uint8_t reserved[3];
+  uint32_t payloadLen;
+} playbackFrameHeader_t;
+
+typedef struct {
+  const uint8_t * data;  // Start of the mapped file
+  uint32_t size;
+  const playbackHeader_t * header;
+  uint32_t pos;          // Offset of the next frame header
+  uint32_t frame;        // Index of the next frame
+} playbackDecoder_t;
+
+typedef struct {
+  uint32_t frames;
+  uint32_t dropped;      // Frames the strand update failed to send
+  uint32_t late;         // Frames whose decode overran the frame period
+  uint32_t decodeErrors;
+} playback_stats_t;
+
+extern int playback_openDecoder(playbackDecoder_t * decoder, const uint8_t * data, uint32_t size);
+extern int playback_decodeFrame(playbackDecoder_t * decoder, pixelColor_t * pixels, uint32_t numPixels);
+extern int playback_start(strand_t * strand, const char * partitionLabel);
+
+// Returns once the task has exited and strand->pixels is the strand's own
+// buffer again, holding the last frame shown
+extern void playback_stop();
+extern void playback_getStats(playback_stats_t * stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LED_PLAYBACK_H */
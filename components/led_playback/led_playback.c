@@ -0,0 +1,237 @@
+/*
+ * Playback of pre-rendered animations stored in a flash data partition
+ */
+
+#include "led_playback.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_partition.h>
+#include <esp_spi_flash.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static strand_t * playbackStrand;
+static pixelColor_t * strandPixels;  // The strand's own buffer, restored on stop
+static pixelColor_t * backBuffer;
+static spi_flash_mmap_handle_t mmapHandle;
+static playbackDecoder_t decoder;
+static playback_stats_t playbackStats;
+static volatile bool active = false;        // Playback task is alive
+static volatile bool stopRequested = false;
+
+int playback_openDecoder(playbackDecoder_t * decoder, const uint8_t * data, uint32_t size)
+{
+  const playbackHeader_t * header = (const playbackHeader_t *)data;
+
+  if (size < sizeof(playbackHeader_t) || header->magic != PLAYBACK_MAGIC ||
+      header->version != PLAYBACK_VERSION || header->numFrames == 0 ||
+      (header->bytesPerPixel != 3 && header->bytesPerPixel != 4)) {
+    return -1;
+  }
+
+  decoder->data = data;
+  decoder->size = size;
+  decoder->header = header;
+  decoder->pos = sizeof(playbackHeader_t);
+  decoder->frame = 0;
+  return 0;
+}
+
+static inline pixelColor_t readPixel(const uint8_t * src, int bytesPerPixel)
+{
+  return pixelFromRGBW(src[0], src[1], src[2], (bytesPerPixel == 4) ? src[3] : 0);
+}
+
+int playback_decodeFrame(playbackDecoder_t * decoder, pixelColor_t * pixels, uint32_t numPixels)
+{
+  // Decodes the next frame over pixels, which must still hold the previous
+  // frame for FRAME_DELTA. Wraps to the first frame after the last one.
+  const playbackHeader_t * header = decoder->header;
+  int bpp = header->bytesPerPixel;
+
+  if (decoder->frame == header->numFrames) {
+    decoder->pos = sizeof(playbackHeader_t);
+    decoder->frame = 0;
+  }
+  if (decoder->pos + sizeof(playbackFrameHeader_t) > decoder->size) {
+    return -1;
+  }
+
+  const playbackFrameHeader_t * frameHeader = (const playbackFrameHeader_t *)(decoder->data + decoder->pos);
+  const uint8_t * src = decoder->data + decoder->pos + sizeof(playbackFrameHeader_t);
+  const uint8_t * end = src + frameHeader->payloadLen;
+  if (frameHeader->payloadLen > decoder->size - decoder->pos - sizeof(playbackFrameHeader_t)) {
+    return -1;
+  }
+
+  uint32_t limit = (header->numPixels < numPixels) ? header->numPixels : numPixels;
+  uint32_t i = 0;
+
+  if (frameHeader->type == FRAME_KEY) {
+    while (src + 1 + bpp <= end) {
+      uint32_t count = src[0];
+      pixelColor_t color = readPixel(src + 1, bpp);
+      src += 1 + bpp;
+      for (; count > 0; count--, i++) {
+        if (i < limit) {
+          pixels[i] = color;
+        }
+      }
+    }
+    // The runs must cover the whole strand, or part of it would keep the
+    // previous frame
+    if (i != header->numPixels) {
+      return -1;
+    }
+  }
+  else if (frameHeader->type == FRAME_DELTA) {
+    while (src + 2 <= end) {
+      uint32_t count = src[1];
+      i += src[0];
+      src += 2;
+      if (src + count * bpp > end) {
+        return -1;
+      }
+      for (; count > 0; count--, i++, src += bpp) {
+        if (i < limit) {
+          pixels[i] = readPixel(src, bpp);
+        }
+      }
+    }
+    if (i > header->numPixels) {
+      return -1;
+    }
+  }
+  else {
+    return -1;
+  }
+  // Bytes left over from a short run or group mean the payload is corrupt
+  if (src != end) {
+    return -1;
+  }
+
+  decoder->pos += sizeof(playbackFrameHeader_t) + frameHeader->payloadLen;
+  decoder->frame++;
+  return 0;
+}
+
+static void playbackTask(void * _args)
+{
+  strand_t * pStrand = playbackStrand;
+  uint32_t bytes = pStrand->numPixels * sizeof(pixelColor_t);
+  pixelColor_t * front = strandPixels;
+  pixelColor_t * back = backBuffer;
+
+  TickType_t period = pdMS_TO_TICKS(1000 / decoder.header->fps);
+  if (period == 0) {
+    period = 1;
+  }
+
+  memcpy(back, front, bytes);
+  if (playback_decodeFrame(&decoder, back, pStrand->numPixels)) {
+    playbackStats.decodeErrors++;
+    stopRequested = true;
+  }
+
+  TickType_t wake = xTaskGetTickCount();
+  while (!stopRequested) {
+    // The back buffer holds the next frame: show it, then decode one ahead
+    pStrand->pixels = back;
+    if (digitalLeds_updatePixels(pStrand)) {
+      playbackStats.dropped++;
+    }
+    else {
+      playbackStats.frames++;
+    }
+    back = front;
+    front = pStrand->pixels;
+
+    memcpy(back, front, bytes);
+    if (playback_decodeFrame(&decoder, back, pStrand->numPixels)) {
+      // Corrupt frame: restart from the first (key) frame
+      playbackStats.decodeErrors++;
+      decoder.pos = sizeof(playbackHeader_t);
+      decoder.frame = 0;
+      if (playback_decodeFrame(&decoder, back, pStrand->numPixels)) {
+        break;
+      }
+    }
+
+    if (xTaskGetTickCount() - wake > period) {
+      playbackStats.late++;
+      wake = xTaskGetTickCount();
+    }
+    vTaskDelayUntil(&wake, period);
+  }
+
+  // Hand the strand its own buffer back, holding the last frame shown
+  if (front != strandPixels) {
+    memcpy(strandPixels, front, bytes);
+  }
+  pStrand->pixels = strandPixels;
+  free(backBuffer);
+  spi_flash_munmap(mmapHandle);
+  active = false;
+
+  vTaskDelete(NULL);
+}
+
+int playback_start(strand_t * strand, const char * partitionLabel)
+{
+  // The caller hands the strand over until playback_stop() returns
+  if (active || strand->pixels == NULL) {
+    return -1;
+  }
+
+  const esp_partition_t * partition = esp_partition_find_first(
+    (esp_partition_type_t)PLAYBACK_PARTITION_TYPE, (esp_partition_subtype_t)PLAYBACK_PARTITION_SUBTYPE,
+    partitionLabel);
+  if (partition == NULL) {
+    return -1;
+  }
+
+  const void * data;
+  if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &data, &mmapHandle) != ESP_OK) {
+    return -1;
+  }
+  if (playback_openDecoder(&decoder, (const uint8_t *)data, partition->size) ||
+      decoder.header->fps == 0 || decoder.header->numPixels > (uint32_t)strand->numPixels) {
+    spi_flash_munmap(mmapHandle);
+    return -1;
+  }
+
+  backBuffer = (pixelColor_t *)malloc(strand->numPixels * sizeof(pixelColor_t));
+  if (backBuffer == NULL) {
+    spi_flash_munmap(mmapHandle);
+    return -1;
+  }
+
+  playbackStrand = strand;
+  strandPixels = strand->pixels;
+  memset(&playbackStats, 0, sizeof(playbackStats));
+  stopRequested = false;
+  active = true;
+
+  if (xTaskCreate(playbackTask, "LED playback", 2048, NULL, 3, NULL) != pdPASS) {
+    active = false;
+    free(backBuffer);
+    spi_flash_munmap(mmapHandle);
+    return -1;
+  }
+  return 0;
+}
+
+void playback_stop()
+{
+  stopRequested = true;
+  while (active) {
+    vTaskDelay(1);
+  }
+}
+
+void playback_getStats(playback_stats_t * stats)
+{
+  *stats = playbackStats;
+}
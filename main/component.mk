@@ -8,4 +8,4 @@
 #
 
 #include $(IDF_PATH)/make/component_common.mk
-COMPONENT_DEPENDS = homekit esp32_digital_led_lib
+COMPONENT_DEPENDS = homekit esp32_digital_led_lib audio_reactive led_compositor
@@ -1,4 +1,6 @@
 #include "esp32_digital_led_lib.h"
+#include "audio_reactive.h"
+#include "led_compositor.h"
 
 #include <stdio.h>
 #include <esp_wifi.h>
@@ -39,6 +41,15 @@ strand_t STRANDS[] = { // Avoid using any of the strapping pins on the ESP32
 
 int STRANDCNT = sizeof(STRANDS)/sizeof(STRANDS[0]);
 
+compositor_t COMPOSITOR;
+
+// Set to 1 to drive the strand from an I2S microphone instead of a static color
+#define AUDIO_REACTIVE 0
+#define AUDIO_I2S_PORT 0
+#define AUDIO_BCK_PIN  26
+#define AUDIO_WS_PIN   25
+#define AUDIO_DATA_PIN 33
+
 void gpioSetup(int gpioNum, int gpioMode, int gpioVal) {
   gpio_num_t gpioNumNative = (gpio_num_t)(gpioNum);
   gpio_mode_t gpioModeNative = (gpio_mode_t)(gpioMode);
@@ -174,41 +185,69 @@ void led_string_set() {
   }
   printf("Requested color h=%f, s=%f, b=%f\n", led_hue, led_saturation, led_brightness);
   printf("Color set to r=%d, g=%d, b=%d, w=%d\n", color.r, color.g, color.b, color.w);
-  strand_t* pStrand = &STRANDS[0];
-  for (uint16_t i = 0; i < pStrand->numPixels; i++) {
-    pStrand->pixels[i] = color;
+  if (AUDIO_REACTIVE) {
+    return;  // The audio render task owns the base layer and picks up the new settings
   }
-  digitalLeds_updatePixels(pStrand);
+  compositor_setColor(&COMPOSITOR, LAYER_BASE, color);
+  compositor_render(&COMPOSITOR);
 }
 
-void led_write(bool on) {
-  strand_t* pStrand = &STRANDS[0];
-  for (uint16_t i = 0; i < pStrand->numPixels; i++) {
-    pStrand->pixels[i] = pixelFromRGBW(on?255:0, on?255:0, on?255:0, on?255:0);
+// Splits the strand into one segment per band, hues spread from led_hue, and
+// lights each segment in proportion to its band level. Beats add a white flash.
+void audio_render(const audioBands_t* bands, void* arg) {
+  compositor_t* comp = (compositor_t*)arg;
+  pixelColor_t colors[AUDIO_NUM_BANDS];
+  int flash = bands->beat ? 255 * led_brightness / 100 : 0;
+
+  for (int b = 0; b < AUDIO_NUM_BANDS; b++) {
+    if (led_on) {
+      hsi2rgbw(led_hue + b * 360 / AUDIO_NUM_BANDS, 100, led_brightness * bands->level[b] / 255, &colors[b]);
+      colors[b].w = max(colors[b].w, flash);
+    } else {
+      colors[b] = pixelFromRGBW(0,0,0,0);
+    }
+  }
+  int numPixels = comp->strand->numPixels;
+  pixelColor_t* pixels = compositor_lockLayer(comp, LAYER_BASE);
+  if (pixels == nullptr) {
+    return;
+  }
+  for (int i = 0; i < numPixels; i++) {
+    pixels[i] = colors[i * AUDIO_NUM_BANDS / numPixels];
   }
-  digitalLeds_updatePixels(pStrand);
+  compositor_unlockLayer(comp, LAYER_BASE);
+  compositor_render(comp);
+}
+
+// Flashes through the overlay layer, so the user's color or effect underneath
+// is left untouched and shows again once the overlay is disabled
+void led_identify_flash(bool on) {
+  compositor_setColor(&COMPOSITOR, LAYER_OVERLAY, pixelFromRGBW(on?255:0, on?255:0, on?255:0, on?255:0));
+  compositor_enable(&COMPOSITOR, LAYER_OVERLAY, true);
+  compositor_render(&COMPOSITOR);
 }
 
 void led_identify_task(void *_args) {
   for (int i=0; i<3; i++) {
     for (int j=0; j<2; j++) {
-      led_write(true);
+      led_identify_flash(true);
       vTaskDelay(100 / portTICK_PERIOD_MS);
-      led_write(false);
+      led_identify_flash(false);
       vTaskDelay(100 / portTICK_PERIOD_MS);
     }
 
     vTaskDelay(250 / portTICK_PERIOD_MS);
   }
 
-  led_write(led_on);
+  compositor_enable(&COMPOSITOR, LAYER_OVERLAY, false);
+  compositor_render(&COMPOSITOR);
 
   vTaskDelete(NULL);
 }
 
 void led_identify(homekit_value_t _value) {
   printf("LED identify\n");
-  xTaskCreate(led_identify_task, "LED identify", 512, NULL, 2, NULL);
+  xTaskCreate(led_identify_task, "LED identify", 2048, NULL, 2, NULL);
 }
 
 homekit_value_t led_on_get() {
@@ -316,10 +355,11 @@ void app_main(void) {
   // Initialize led strip
   gpioSetup(16, OUTPUT, LOW);
 
-  if (digitalLeds_initStrands(STRANDS, STRANDCNT)) {
+  if (digitalLeds_initStrands(STRANDS, STRANDCNT) || compositor_init(&COMPOSITOR, &STRANDS[0])) {
     ets_printf("Init FAILURE: halting\n");
     while (true) {};
   }
+  compositor_enable(&COMPOSITOR, LAYER_BASE, true);
 
   // Initialize NVS
   esp_err_t ret = nvs_flash_init();
@@ -330,4 +370,14 @@ void app_main(void) {
   ESP_ERROR_CHECK( ret );
 
   wifi_init();
+
+  if (AUDIO_REACTIVE) {
+    audioReactive_config_t audioConfig = {
+      .i2sPort = AUDIO_I2S_PORT, .bckPin = AUDIO_BCK_PIN, .wsPin = AUDIO_WS_PIN, .dataPin = AUDIO_DATA_PIN,
+      .render = audio_render, .renderArg = &COMPOSITOR
+    };
+    if (audioReactive_init(&audioConfig)) {
+      printf("Audio init FAILURE\n");
+    }
+  }
 }
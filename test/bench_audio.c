@@ -0,0 +1,202 @@
+/*
+ * Audio-reactive frame cost from a WAV file: FFT and band grouping, then the
+ * per-band segment render onto a 300-pixel RGBW strand sent through the
+ * emulated RMT, against the time one frame of samples takes to capture.
+ *
+ *   bench_audio [file.wav]
+ *
+ * The WAV must be 16-bit PCM; stereo is mixed down and other sample rates
+ * are resampled to AUDIO_SAMPLE_RATE by nearest sample. Without an argument
+ * a ten-second track with a 120 bpm kick is synthesised to build/ first.
+ * The wire time is the line time of the emulated frame, during which the
+ * render task is blocked in digitalLeds_updatePixels() on the device.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_fft.h"
+#include "esp32_digital_led_lib.h"
+#include "rmt_emulator.h"
+
+#define NUM_PIXELS 300
+#define SYNTH_PATH "build/bench_audio.wav"
+
+static int64_t nowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void put16(FILE * f, uint16_t v) { fputc(v & 0xff, f); fputc(v >> 8, f); }
+static void put32(FILE * f, uint32_t v) { put16(f, v & 0xffff); put16(f, v >> 16); }
+
+static int writeSynthWav(const char * path)
+{
+  uint32_t numSamples = AUDIO_SAMPLE_RATE * 10;
+  FILE * f = fopen(path, "wb");
+  if (f == NULL) {
+    return -1;
+  }
+  fwrite("RIFF", 1, 4, f);
+  put32(f, 36 + numSamples * 2);
+  fwrite("WAVEfmt ", 1, 8, f);
+  put32(f, 16);
+  put16(f, 1);  // PCM
+  put16(f, 1);  // Mono
+  put32(f, AUDIO_SAMPLE_RATE);
+  put32(f, AUDIO_SAMPLE_RATE * 2);
+  put16(f, 2);
+  put16(f, 16);
+  fwrite("data", 1, 4, f);
+  put32(f, numSamples * 2);
+
+  srand(1);
+  for (uint32_t i = 0; i < numSamples; i++) {
+    double t = (double)i / AUDIO_SAMPLE_RATE;
+    double beatT = fmod(t, 0.5);
+    double kick = exp(-beatT * 20) * sin(2 * M_PI * 55 * beatT);
+    double chord = sin(2 * M_PI * 220 * t) + sin(2 * M_PI * 277.2 * t) + sin(2 * M_PI * 329.6 * t);
+    double hiss = (rand() / (double)RAND_MAX - 0.5) * 0.2;
+    put16(f, (uint16_t)(int16_t)(9000 * kick + 2500 * chord / 3 + 3000 * hiss));
+  }
+  return fclose(f);
+}
+
+static int16_t * readWav(const char * path, uint32_t * numSamples)
+{
+  FILE * f = fopen(path, "rb");
+  if (f == NULL) {
+    return NULL;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t * data = malloc(size);
+  if (data == NULL || fread(data, 1, size, f) != (size_t)size || size < 12 || memcmp(data, "RIFF", 4) ||
+      memcmp(data + 8, "WAVE", 4)) {
+    fclose(f);
+    free(data);
+    return NULL;
+  }
+  fclose(f);
+
+  int channels = 0, bits = 0;
+  uint32_t rate = 0;
+  int16_t * out = NULL;
+  for (long pos = 12; pos + 8 <= size;) {
+    uint32_t len = data[pos + 4] | data[pos + 5] << 8 | data[pos + 6] << 16 | (uint32_t)data[pos + 7] << 24;
+    const uint8_t * body = data + pos + 8;
+    if (len > size - pos - 8) {
+      len = size - pos - 8;
+    }
+    if (!memcmp(data + pos, "fmt ", 4) && len >= 16) {
+      channels = body[2] | body[3] << 8;
+      rate = body[4] | body[5] << 8 | body[6] << 16 | (uint32_t)body[7] << 24;
+      bits = body[14] | body[15] << 8;
+    }
+    else if (!memcmp(data + pos, "data", 4) && bits == 16 && channels > 0 && rate > 0) {
+      uint32_t frames = len / (2 * channels);
+      *numSamples = (uint64_t)frames * AUDIO_SAMPLE_RATE / rate;
+      out = malloc(*numSamples * sizeof(int16_t));
+      for (uint32_t i = 0; out && i < *numSamples; i++) {
+        const uint8_t * frame = body + (uint64_t)i * rate / AUDIO_SAMPLE_RATE * 2 * channels;
+        int32_t sum = 0;
+        for (int c = 0; c < channels; c++) {
+          sum += (int16_t)(frame[2 * c] | frame[2 * c + 1] << 8);
+        }
+        out[i] = sum / channels;
+      }
+      break;
+    }
+    pos += 8 + len + (len & 1);
+  }
+  free(data);
+  return out;
+}
+
+static void renderBands(strand_t * strand, const audioBands_t * bands)
+{
+  // Same layout as main.c: one segment per band, hue per segment, white on beats
+  static const pixelColor_t hues[AUDIO_NUM_BANDS] = {
+    { { 255, 0, 0, 0 } }, { { 255, 128, 0, 0 } }, { { 255, 255, 0, 0 } }, { { 0, 255, 0, 0 } },
+    { { 0, 255, 255, 0 } }, { { 0, 0, 255, 0 } }, { { 128, 0, 255, 0 } }, { { 255, 0, 255, 0 } },
+  };
+  pixelColor_t colors[AUDIO_NUM_BANDS];
+  for (int b = 0; b < AUDIO_NUM_BANDS; b++) {
+    int level = bands->level[b];
+    colors[b] = pixelFromRGBW(hues[b].r * level / 255, hues[b].g * level / 255, hues[b].b * level / 255,
+                              bands->beat ? 255 : 0);
+  }
+  for (int i = 0; i < strand->numPixels; i++) {
+    strand->pixels[i] = colors[i * AUDIO_NUM_BANDS / strand->numPixels];
+  }
+  digitalLeds_updatePixels(strand);
+}
+
+int main(int argc, char ** argv)
+{
+  const char * path = (argc > 1) ? argv[1] : SYNTH_PATH;
+  if (argc <= 1 && writeSynthWav(path)) {
+    printf("cannot write %s\n", path);
+    return 1;
+  }
+  uint32_t numSamples = 0;
+  int16_t * samples = readWav(path, &numSamples);
+  if (samples == NULL || numSamples < AUDIO_FFT_SIZE) {
+    printf("%s: not a 16-bit PCM WAV of at least one frame\n", path);
+    return 1;
+  }
+
+  strand_t strand;
+  memset(&strand, 0, sizeof(strand));
+  strand.rmtChannel = 0;
+  strand.gpioNum = 16;
+  strand.ledType = LED_SK6812W_V1;
+  strand.numPixels = NUM_PIXELS;
+  rmtEmu_init();
+  if (digitalLeds_initStrands(&strand, 1)) {
+    return 1;
+  }
+  audioFft_init();
+
+  double budgetUs = AUDIO_FFT_SIZE * 1e6 / AUDIO_SAMPLE_RATE;
+  uint32_t frames = numSamples / AUDIO_FFT_SIZE;
+  double fftUsTotal = 0, fftUsMax = 0, renderUsTotal = 0, renderUsMax = 0, wireUs = 0;
+  uint32_t beats = 0, overBudget = 0;
+
+  for (uint32_t f = 0; f < frames; f++) {
+    audioBands_t bands;
+    int64_t start = nowNs();
+    audioFft_analyse(samples + f * AUDIO_FFT_SIZE, &bands);
+    double fftUs = (nowNs() - start) / 1000.0;
+
+    uint64_t overhead = rmtEmu_overheadNs();
+    start = nowNs();
+    renderBands(&strand, &bands);
+    double renderUs = (nowNs() - start - (rmtEmu_overheadNs() - overhead)) / 1000.0;
+    wireUs = rmtEmu_channel(strand.rmtChannel)->itemNs / 1000.0;
+
+    fftUsTotal += fftUs;
+    renderUsTotal += renderUs;
+    fftUsMax = (fftUs > fftUsMax) ? fftUs : fftUsMax;
+    renderUsMax = (renderUs > renderUsMax) ? renderUs : renderUsMax;
+    beats += bands.beat;
+    overBudget += (fftUs + renderUs + wireUs > budgetUs);
+  }
+
+  printf("%s: %u frames of %d samples, %u beats, host timings\n", path, frames, AUDIO_FFT_SIZE, beats);
+  printf("frame budget       %8.1f us\n", budgetUs);
+  printf("fft + bands        %8.1f us mean  %8.1f us max\n", fftUsTotal / frames, fftUsMax);
+  printf("render + pack      %8.1f us mean  %8.1f us max\n", renderUsTotal / frames, renderUsMax);
+  printf("wire (%d px)      %8.1f us\n", NUM_PIXELS, wireUs);
+  printf("worst total        %8.1f us (%.0f%% of budget), %u frames over\n",
+         fftUsMax + renderUsMax + wireUs, 100 * (fftUsMax + renderUsMax + wireUs) / budgetUs, overBudget);
+
+  free(samples);
+  return overBudget ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Compositor blend cost for 300 and 1000 pixel strands with 1 to 4 per-pixel
+ * layers, blending every layer and reusing the cached blend when only the top
+ * layer changed. Both must produce the same pixels. A render whose transmit
+ * fails must send the frame again on the next render.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "led_compositor.h"
+#include "rmt_emulator.h"
+
+#define ROUNDS 200
+
+static const int blendModes[COMPOSITOR_MAX_LAYERS] = { BLEND_NORMAL, BLEND_ADD, BLEND_MULTIPLY, BLEND_MAX };
+
+static void fillLayer(compositor_t * comp, int layer, int frame)
+{
+  pixelColor_t * pixels = compositor_lockLayer(comp, layer);
+  for (uint32_t i = 0; i < comp->strand->numPixels; i++) {
+    pixels[i] = pixelFromRGBW(i * (layer + 3) + frame, 255 - i - layer * 40, frame * 5 + layer * 60, i);
+  }
+  compositor_unlockLayer(comp, layer);
+}
+
+// Mean blend time over ROUNDS renders, with layers firstChanged and up
+// changed before each. blendUs is in whole microseconds but both ends are
+// truncated, so the mean over many renders is still accurate.
+static double timeBlend(compositor_t * comp, int firstChanged, int numLayers)
+{
+  uint64_t blendUs = 0;
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int l = firstChanged; l < numLayers; l++) {
+      fillLayer(comp, l, r);
+    }
+    compositor_render(comp);
+    blendUs += comp->blendUs;
+  }
+  return (double)blendUs / ROUNDS;
+}
+
+static int runCase(int numPixels, int numLayers)
+{
+  strand_t strand;
+  memset(&strand, 0, sizeof(strand));
+  strand.gpioNum = 16;
+  strand.ledType = LED_SK6812W_V1;
+  strand.numPixels = numPixels;
+
+  rmtEmu_init();
+  compositor_t comp;
+  if (digitalLeds_initStrands(&strand, 1) || compositor_init(&comp, &strand)) {
+    printf("%d px: init failed\n", numPixels);
+    return 1;
+  }
+  for (int l = 0; l < numLayers; l++) {
+    compositor_setAlpha(&comp, l, 255 - l * 50, blendModes[l]);
+    compositor_enable(&comp, l, 1);
+  }
+
+  double fullUs = timeBlend(&comp, 0, numLayers);
+  double topUs = timeBlend(&comp, numLayers - 1, numLayers);
+
+  // The cached result must match a full blend of the same layers
+  pixelColor_t cached[1000];
+  memcpy(cached, strand.pixels, numPixels * sizeof(pixelColor_t));
+  compositor_setAlpha(&comp, 0, comp.layers[0].alpha, comp.layers[0].blendMode);
+  compositor_render(&comp);
+  int same = !memcmp(cached, strand.pixels, numPixels * sizeof(pixelColor_t));
+
+  // Wire time of one frame: 32 bits of 1.25 us per RGBW pixel
+  double frameUs = numPixels * 32 * 1.25;
+  printf("%5d px  %d layer%s  %9.1f  %11.1f  %7.2f%%  %s\n", numPixels, numLayers, numLayers > 1 ? "s" : " ",
+         fullUs, topUs, 100.0 * fullUs / frameUs, same ? "ok" : "MISMATCH");
+  return !same;
+}
+
+static int checkRetransmit(void)
+{
+  strand_t strand;
+  memset(&strand, 0, sizeof(strand));
+  strand.gpioNum = 16;
+  strand.ledType = LED_SK6812W_V1;
+  strand.numPixels = 300;
+
+  rmtEmu_init();
+  compositor_t comp;
+  if (digitalLeds_initStrands(&strand, 1) || compositor_init(&comp, &strand)) {
+    return 1;
+  }
+  compositor_enable(&comp, LAYER_BASE, 1);
+  fillLayer(&comp, LAYER_BASE, 0);
+  const rmtEmu_channel_t * ch = rmtEmu_channel(strand.rmtChannel);
+
+  // The frame stalls and times out, so the next render must send it again
+  rmtEmu_stall(strand.rmtChannel);
+  int failedRet = compositor_render(&comp);
+  uint32_t frames = ch->frames;
+  int retryRet = compositor_render(&comp);
+  int resent = ch->frames == frames + 1 && ch->decodedLen == 300 * 4;
+  for (int i = 0; i < 300 && resent; i++) {
+    const uint8_t * p = ch->decoded + i * 4;
+    resent = p[0] == strand.pixels[i].g && p[1] == strand.pixels[i].r &&
+             p[2] == strand.pixels[i].b && p[3] == strand.pixels[i].w;
+  }
+  // Once it went out, nothing is left to send
+  frames = ch->frames;
+  int idleRet = compositor_render(&comp);
+  int idle = ch->frames == frames;
+
+  int ok = failedRet == -1 && retryRet == 0 && resent && idleRet == 0 && idle;
+  printf("retransmit after a failed update: %s  %s\n", resent ? "yes" : "no", ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+int main(void)
+{
+  static const int sizes[] = { 300, 1000 };
+  int failed = 0;
+
+  printf("strand   layers    full us  top-only us  of frame\n");
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for (int n = 1; n <= COMPOSITOR_MAX_LAYERS; n++) {
+      failed |= runCase(sizes[s], n);
+    }
+  }
+  failed |= checkRetransmit();
+  return failed;
+}
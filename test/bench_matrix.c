@@ -0,0 +1,107 @@
+/*
+ * Matrix remap through the precomputed index table against computing every
+ * pixel's strand index on the fly, for square panels of 8x8 serpentine
+ * tiles chained serpentine and rotated 90 degrees. Both must produce the
+ * same strand, and ledMatrix_init() must reject layouts with a negative
+ * dimension even when the products come out positive, and layouts whose
+ * size only fits the strand after overflowing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "led_matrix.h"
+
+#define ROUNDS 2000
+
+static int64_t nowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void remapPerPixel(ledMatrix_t * matrix, const matrixLayout_t * layout)
+{
+  pixelColor_t * pixels = matrix->strand->pixels;
+  for (int y = 0; y < matrix->height; y++) {
+    for (int x = 0; x < matrix->width; x++) {
+      pixels[ledMatrix_mapXY(layout, x, y)] = matrix->frame[y * matrix->width + x];
+    }
+  }
+}
+
+static int checkRejected(strand_t * strand, int tileWidth, int tileHeight, int tilesX, int tilesY)
+{
+  matrixLayout_t layout = { tileWidth, tileHeight, tilesX, tilesY, MATRIX_SERPENTINE, MATRIX_PROGRESSIVE, MATRIX_ROTATE_0 };
+  ledMatrix_t matrix;
+  int ret = ledMatrix_init(&matrix, strand, &layout);
+  int ok = ret == -1 && matrix.indexTable == NULL && matrix.frame == NULL;
+  printf("reject %3d x %3d tiles of %3d x %3d: %s\n", tilesX, tilesY, tileWidth, tileHeight, ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+int main(void)
+{
+  static const int sizes[] = { 16, 32, 48, 64 };
+  int failed = 0;
+
+  printf("panel   pixels  table bytes  table ns/frame  per-pixel ns/frame  speedup\n");
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    int size = sizes[s];
+    matrixLayout_t layout = { 8, 8, size / 8, size / 8, MATRIX_SERPENTINE, MATRIX_SERPENTINE, MATRIX_ROTATE_90 };
+    strand_t strand;
+    memset(&strand, 0, sizeof(strand));
+    strand.numPixels = size * size;
+    strand.pixels = calloc(strand.numPixels, sizeof(pixelColor_t));
+    pixelColor_t * expected = calloc(strand.numPixels, sizeof(pixelColor_t));
+
+    ledMatrix_t matrix;
+    if (ledMatrix_init(&matrix, &strand, &layout)) {
+      printf("%dx%d: init failed\n", size, size);
+      return 1;
+    }
+    for (int i = 0; i < size * size; i++) {
+      matrix.frame[i].num = i * 2654435761u;
+    }
+
+    int64_t start = nowNs();
+    for (int r = 0; r < ROUNDS; r++) {
+      ledMatrix_remap(&matrix);
+    }
+    double tableNs = (double)(nowNs() - start) / ROUNDS;
+    memcpy(expected, strand.pixels, strand.numPixels * sizeof(pixelColor_t));
+
+    memset(strand.pixels, 0, strand.numPixels * sizeof(pixelColor_t));
+    start = nowNs();
+    for (int r = 0; r < ROUNDS; r++) {
+      remapPerPixel(&matrix, &layout);
+    }
+    double mathNs = (double)(nowNs() - start) / ROUNDS;
+
+    int same = !memcmp(expected, strand.pixels, strand.numPixels * sizeof(pixelColor_t));
+    printf("%2dx%-2d  %7d  %11zu  %14.0f  %18.0f  %6.1fx%s\n", size, size, size * size,
+           size * size * sizeof(uint32_t), tableNs, mathNs, mathNs / tableNs, same ? "" : "  MISMATCH");
+    failed |= !same;
+
+    free(matrix.indexTable);
+    free(matrix.frame);
+    free(expected);
+    free(strand.pixels);
+  }
+
+  strand_t strand;
+  memset(&strand, 0, sizeof(strand));
+  strand.numPixels = 256;
+  strand.pixels = calloc(strand.numPixels, sizeof(pixelColor_t));
+  failed |= checkRejected(&strand, -8, 8, -2, 1);
+  failed |= checkRejected(&strand, 8, -8, 1, -2);
+  failed |= checkRejected(&strand, 0, 8, 2, 2);
+  failed |= checkRejected(&strand, 8, 8, 4, 4);  // Larger than the strand
+  failed |= checkRejected(&strand, 65536, 65536, 1, 1);  // 2^32 pixels, 0 in 32 bits
+  failed |= checkRejected(&strand, 8, 8, 0x40000000, 0x40000000);  // Each side overflows int
+  free(strand.pixels);
+  return failed;
+}
@@ -0,0 +1,119 @@
+/*
+ * Memory saved by palette strands, and what expanding the indices costs per frame
+ *
+ * Each strand is initialised on the emulated RMT, filled with a pattern and
+ * transmitted repeatedly. The driver's time per frame is everything spent in
+ * digitalLeds_updatePixels() and its refill interrupts, minus the emulator's
+ * own work; for normal strands that includes packPixels() over the whole
+ * frame, for palette strands the per-window expansion through the palette.
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp32_digital_led_lib.h"
+#include "rmt_emulator.h"
+
+#define FRAMES 200
+
+static int64_t nowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static pixelColor_t patternColor(uint32_t i)
+{
+  return pixelFromRGBW(i * 7, 255 - i, i * 13 + 5, i * 3);
+}
+
+typedef struct {
+  size_t heapBytes;
+  double usPerFrame;
+  int ok;
+} result_t;
+
+static result_t runStrand(int ledType, int numPixels, int paletteMode)
+{
+  result_t result = { 0, 0, 1 };
+  strand_t strand;
+  memset(&strand, 0, sizeof(strand));
+  strand.rmtChannel = 0;
+  strand.gpioNum = 16;
+  strand.ledType = ledType;
+  strand.numPixels = numPixels;
+  strand.paletteMode = paletteMode;
+
+  rmtEmu_init();
+  size_t heapBefore = mallinfo2().uordblks;
+  if (digitalLeds_initStrands(&strand, 1)) {
+    result.ok = 0;
+    return result;
+  }
+  result.heapBytes = mallinfo2().uordblks - heapBefore;
+
+  int bpp = ledParamsAll[ledType].bytesPerPixel;
+  uint8_t * expected = malloc(numPixels * bpp);
+  for (int i = 0; i < numPixels; i++) {
+    pixelColor_t color = patternColor(paletteMode ? i % DIGITALLEDS_PALETTE_SIZE : i);
+    if (paletteMode) {
+      strand.palette[i % DIGITALLEDS_PALETTE_SIZE] = color;
+      strand.pixelIdx[i] = i % DIGITALLEDS_PALETTE_SIZE;
+    }
+    else {
+      strand.pixels[i] = color;
+    }
+    uint8_t * p = expected + i * bpp;
+    p[0] = color.g;
+    p[1] = color.r;
+    p[2] = color.b;
+    if (bpp == 4) {
+      p[3] = color.w;
+    }
+  }
+
+  uint64_t overheadBefore = rmtEmu_overheadNs();
+  int64_t start = nowNs();
+  for (int f = 0; f < FRAMES; f++) {
+    if (digitalLeds_updatePixels(&strand)) {
+      result.ok = 0;
+    }
+  }
+  int64_t driverNs = nowNs() - start - (rmtEmu_overheadNs() - overheadBefore);
+  result.usPerFrame = driverNs / 1000.0 / FRAMES;
+
+  const rmtEmu_channel_t * ch = rmtEmu_channel(0);
+  if (ch->decodedLen != (uint32_t)(numPixels * bpp) || memcmp(ch->decoded, expected, ch->decodedLen)) {
+    result.ok = 0;
+  }
+  free(expected);
+  return result;
+}
+
+int main(void)
+{
+  static const struct { int ledType; const char * name; } types[] = {
+    { LED_WS2812B_V3, "RGB " },
+    { LED_SK6812W_V1, "RGBW" },
+  };
+  static const int sizes[] = { 60, 300, 1000, 4000 };
+  int failed = 0;
+
+  printf("type  pixels   heap normal  heap palette  saved   us/frame normal  us/frame palette\n");
+  for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      result_t normal = runStrand(types[t].ledType, sizes[s], 0);
+      result_t palette = runStrand(types[t].ledType, sizes[s], 1);
+      printf("%s  %6d  %11zu  %12zu  %4.0f%%  %15.1f  %16.1f%s\n",
+             types[t].name, sizes[s], normal.heapBytes, palette.heapBytes,
+             100.0 * (1.0 - (double)palette.heapBytes / normal.heapBytes),
+             normal.usPerFrame, palette.usPerFrame,
+             (normal.ok && palette.ok) ? "" : "  MISMATCH");
+      failed |= !normal.ok || !palette.ok;
+    }
+  }
+  return failed;
+}
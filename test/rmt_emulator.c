@@ -0,0 +1,246 @@
+/*
+ * Host model of the ESP32 RMT transmitter, for exercising the LED driver
+ */
+
+#include "rmt_emulator.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <soc/rmt_struct.h>
+
+#define ITEMS_PER_BLOCK 64
+#define TICK_NS         50       // APB clock at DIVIDER 4
+#define BIT_ONE_TICKS   11       // Between the longest T0H and the shortest T1H
+#define RUNAWAY_ITEMS   (RMTEMU_MAX_BYTES * 16)
+
+enum channel_states {
+  CH_IDLE,
+  CH_RUNNING,
+  CH_STALLED,
+};
+
+typedef struct {
+  int state;
+  int stallNext;         // Stall the next transmission
+  uint32_t stallAfter;   // Item count at which a running transmission stalls, 0 for never
+  uint32_t pos;          // Next item to read
+  uint32_t sinceThr;
+  uint32_t bits, numBits;
+  rmtEmu_channel_t pub;
+} emuChannel_t;
+
+static emuChannel_t channels[RMTEMU_CHANNELS];
+static uint32_t latencyItems;
+static uint64_t isrNs;        // Time spent in the driver's handler
+static uint64_t overheadNs;   // Time spent emulating, excluding the handler
+
+static inline uint32_t thrBit(int ch) { return 1u << (24 + ch); }
+static inline uint32_t endBit(int ch) { return 1u << (ch * 3); }
+
+static int64_t nowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void applyClear(void)
+{
+  RMT.int_raw.val &= ~RMT.int_clr.val;
+  RMT.int_clr.val = 0;
+}
+
+static void deliverInterrupts(void)
+{
+  // The handler services one event per channel per call, like the hardware
+  // re-entering it while int_st is still set
+  for (int n = 0; n < 2 * RMTEMU_CHANNELS; n++) {
+    uint32_t st = RMT.int_raw.val & RMT.int_ena.val;
+    if (st == 0 || host_rmtIsr == NULL) {
+      return;
+    }
+    RMT.int_st.val = st;
+    int64_t start = nowNs();
+    host_rmtIsr(NULL);
+    uint64_t ns = nowNs() - start;
+    isrNs += ns;
+    RMT.int_st.val = 0;
+    applyClear();
+
+    for (int ch = 0; ch < RMTEMU_CHANNELS; ch++) {
+      if (st & thrBit(ch)) {
+        rmtEmu_channel_t * pub = &channels[ch].pub;
+        pub->isrNsTotal += ns;
+        if (pub->isrCount < RMTEMU_MAX_REFILLS) {
+          pub->isrNs[pub->isrCount++] = ns;
+        }
+        if (ns > pub->isrNsMax) {
+          pub->isrNsMax = ns;
+        }
+      }
+    }
+  }
+}
+
+static void startChannel(int ch)
+{
+  emuChannel_t * pCh = &channels[ch];
+  uint32_t frames = pCh->pub.frames;
+
+  memset(&pCh->pub, 0, sizeof(pCh->pub));
+  pCh->pub.frames = frames;
+  pCh->pub.memBlocks = RMT.conf_ch[ch].conf0.mem_size;
+  pCh->pub.limit = RMT.tx_lim_ch[ch].limit;
+  pCh->pos = 0;
+  pCh->sinceThr = 0;
+  pCh->bits = 0;
+  pCh->numBits = 0;
+  pCh->state = CH_RUNNING;
+  pCh->stallAfter = pCh->stallNext ? pCh->pub.memBlocks * ITEMS_PER_BLOCK / 2 : 0;
+  pCh->stallNext = 0;
+}
+
+static void stepChannel(int ch)
+{
+  emuChannel_t * pCh = &channels[ch];
+  uint32_t memItems = RMT.conf_ch[ch].conf0.mem_size * ITEMS_PER_BLOCK;
+  volatile rmt_item32_t * mem = (volatile rmt_item32_t *)&RMTMEM.chan[ch];  // Spans the borrowed blocks
+  rmt_item32_t item;
+
+  item.val = mem[pCh->pos].val;
+  if (item.duration0 == 0 || item.duration1 == 0) {
+    pCh->state = CH_IDLE;
+    pCh->pub.frames++;
+    RMT.int_raw.val |= endBit(ch);
+    return;
+  }
+
+  pCh->pub.items++;
+  pCh->pub.itemNs += (item.duration0 + item.duration1) * TICK_NS;
+  pCh->bits = (pCh->bits << 1) | (item.duration0 >= BIT_ONE_TICKS);
+  if (++pCh->numBits == 8) {
+    if (pCh->pub.decodedLen < RMTEMU_MAX_BYTES) {
+      pCh->pub.decoded[pCh->pub.decodedLen++] = pCh->bits;
+    }
+    pCh->bits = 0;
+    pCh->numBits = 0;
+  }
+
+  pCh->pos = (memItems > 0) ? (pCh->pos + 1) % memItems : 0;
+  if (++pCh->sinceThr == RMT.tx_lim_ch[ch].limit) {
+    pCh->sinceThr = 0;
+    pCh->pub.refills++;
+    RMT.int_raw.val |= thrBit(ch);
+  }
+
+  if (pCh->stallAfter && pCh->pub.items == pCh->stallAfter) {
+    pCh->state = CH_STALLED;
+  }
+  else if (pCh->pub.items > RUNAWAY_ITEMS) {
+    pCh->state = CH_IDLE;  // Never reached an end item
+  }
+}
+
+static int stepRunning(void)
+{
+  int running = 0;
+  for (int ch = 0; ch < RMTEMU_CHANNELS; ch++) {
+    if (channels[ch].state == CH_RUNNING) {
+      stepChannel(ch);
+      running = 1;
+    }
+  }
+  deliverInterrupts();
+  return running;
+}
+
+static void runHardware(SemaphoreHandle_t sem, TickType_t ticks)
+{
+  applyClear();
+
+  for (int ch = 0; ch < RMTEMU_CHANNELS; ch++) {
+    if (channels[ch].state == CH_STALLED) {
+      // The driver gave up on this transmission and reset the read pointer,
+      // but the transmitter is still going
+      startChannel(ch);
+    }
+    if (RMT.conf_ch[ch].conf1.tx_start) {
+      RMT.conf_ch[ch].conf1.tx_start = 0;
+      startChannel(ch);
+    }
+  }
+  deliverInterrupts();
+
+  if (ticks == 0) {
+    for (uint32_t n = 0; n < latencyItems && !host_semaphoreGiven(sem); n++) {
+      stepRunning();
+    }
+    return;
+  }
+
+  while (!host_semaphoreGiven(sem) && stepRunning()) {
+  }
+  for (uint32_t n = 0; n < latencyItems && stepRunning(); n++) {
+  }
+}
+
+static void blockHook(SemaphoreHandle_t sem, TickType_t ticks)
+{
+  int64_t start = nowNs();
+  uint64_t isrStart = isrNs;
+  runHardware(sem, ticks);
+  overheadNs += (nowNs() - start) - (isrNs - isrStart);
+}
+
+void rmtEmu_init(void)
+{
+  memset((void *)&RMT, 0, sizeof(RMT));
+  memset((void *)&RMTMEM, 0, sizeof(RMTMEM));
+  memset(channels, 0, sizeof(channels));
+  latencyItems = 0;
+  isrNs = 0;
+  overheadNs = 0;
+  host_blockHook = blockHook;
+}
+
+void rmtEmu_stall(int channel)
+{
+  channels[channel].stallNext = 1;
+}
+
+void rmtEmu_setLatency(uint32_t items)
+{
+  latencyItems = items;
+}
+
+uint64_t rmtEmu_overheadNs(void)
+{
+  return overheadNs;
+}
+
+const rmtEmu_channel_t * rmtEmu_channel(int channel)
+{
+  return &channels[channel].pub;
+}
+
+int64_t rmtEmu_refillBudgetNs(int channel)
+{
+  const rmtEmu_channel_t * pub = &channels[channel].pub;
+  if (pub->items == 0) {
+    return 0;
+  }
+  // After a threshold event the other half of the memory, limit items, is
+  // all that is left to send while the handler refills
+  return (int64_t)(pub->itemNs * pub->limit / pub->items);
+}
+
+int64_t rmtEmu_refillMarginNs(int channel)
+{
+  if (channels[channel].pub.items == 0) {
+    return 0;
+  }
+  return rmtEmu_refillBudgetNs(channel) - (int64_t)channels[channel].pub.isrNsMax;
+}
@@ -0,0 +1,74 @@
+/*
+ * Host model of the ESP32 RMT transmitter, for exercising the LED driver
+ *
+ * Channels started with conf1.tx_start read items from RMTMEM across
+ * conf0.mem_size blocks, wrapping around, raise tx_thr_event every
+ * tx_lim_ch.limit items and tx_end at the first zero item. Interrupts are
+ * delivered to the handler registered with esp_intr_alloc() as soon as they
+ * are raised and enabled. Transmission advances whenever the driver would
+ * block on a semaphore, so a whole frame runs inside digitalLeds_updatePixels().
+ *
+ * Sent items are decoded back into bytes, and every refill interrupt is timed
+ * against the time the channel takes to drain the other half of its memory.
+ */
+
+#ifndef RMT_EMULATOR_H
+#define RMT_EMULATOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RMTEMU_CHANNELS  8
+#define RMTEMU_MAX_BYTES (128 * 1024)
+#define RMTEMU_MAX_REFILLS (RMTEMU_MAX_BYTES * 8 / 32)  // At the smallest threshold, half a block
+
+typedef struct {
+  uint32_t frames;       // Transmissions that reached their end item
+  uint32_t items;        // Items sent by the last transmission
+  uint32_t refills;      // tx_thr_event interrupts raised by the last transmission
+  uint32_t memBlocks;    // conf0.mem_size of the last transmission
+  uint32_t limit;        // tx_lim_ch.limit of the last transmission
+  uint64_t itemNs;       // Line time of the last transmission
+  uint64_t isrNsMax;     // Longest refill interrupt of the last transmission
+  uint64_t isrNsTotal;
+  uint32_t isrCount;     // Refill interrupts timed in isrNs[]
+  uint32_t isrNs[RMTEMU_MAX_REFILLS];
+  uint32_t decodedLen;   // Bytes decoded from the last transmission
+  uint8_t decoded[RMTEMU_MAX_BYTES];
+} rmtEmu_channel_t;
+
+// Clears the peripheral and installs the emulator behind xSemaphoreTake()
+extern void rmtEmu_init(void);
+
+// The next transmission on channel stops after half its memory and never
+// ends. Once the driver has reset the channel, the stalled transmitter runs
+// again from item 0 of whatever the channel memory holds.
+extern void rmtEmu_stall(int channel);
+
+// Items a running channel sends each time the driver polls a semaphore
+// without waiting, and after it wakes the driver, modelling how far the line
+// gets before the woken task runs
+extern void rmtEmu_setLatency(uint32_t items);
+
+extern const rmtEmu_channel_t * rmtEmu_channel(int channel);
+
+// Host time spent emulating the peripheral so far, excluding the driver's
+// interrupt handler; subtract it to get the driver's own cost
+extern uint64_t rmtEmu_overheadNs(void);
+
+// Line time of the items left in the channel memory when a threshold
+// interrupt is raised: how long the refill may take, for the last transmission
+extern int64_t rmtEmu_refillBudgetNs(int channel);
+
+// Smallest time left over between the end of a refill interrupt and the
+// moment the channel would have run out of items, for the last transmission
+extern int64_t rmtEmu_refillMarginNs(int channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RMT_EMULATOR_H */
@@ -0,0 +1,154 @@
+/*
+ * Minimal stand-ins for the ESP-IDF and FreeRTOS APIs used by the
+ * components, so their portable parts can be built and run on a host.
+ */
+
+#ifndef HOST_IDF_H
+#define HOST_IDF_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DRAM_ATTR
+#define IRAM_ATTR
+
+typedef int esp_err_t;
+#define ESP_OK    0
+#define ESP_FAIL -1
+
+// Heap
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+void * heap_caps_malloc(size_t size, uint32_t caps);
+
+// Timer
+int64_t esp_timer_get_time(void);
+
+// FreeRTOS
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef int portBASE_TYPE;
+typedef void * SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+typedef void * QueueHandle_t;
+typedef void * TaskHandle_t;
+
+#define pdFALSE 0
+#define pdTRUE  1
+#define pdPASS  1
+#define portMAX_DELAY      0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(ms))
+#define portYIELD_FROM_ISR()
+
+// Spinlocks. Everything runs on one thread here, so a lock is never
+// contended; taking one twice means a handler ran inside a critical section.
+typedef struct {
+  int locked;
+} portMUX_TYPE;
+void vPortCPUInitializeMutex(portMUX_TYPE * mux);
+void host_enterCritical(portMUX_TYPE * mux);
+void host_exitCritical(portMUX_TYPE * mux);
+#define portENTER_CRITICAL(mux)     host_enterCritical(mux)
+#define portEXIT_CRITICAL(mux)      host_exitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux) host_enterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)  host_exitCritical(mux)
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t * woken);
+
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t * wake, TickType_t period);
+BaseType_t xTaskCreate(void (*fn)(void *), const char * name, uint32_t stack, void * arg,
+                       int prio, TaskHandle_t * handle);
+void vTaskDelete(TaskHandle_t task);
+
+// Called by xSemaphoreTake() when it would block, to let a test harness
+// (the RMT emulator) run the "hardware" that eventually gives the semaphore
+extern void (*host_blockHook)(SemaphoreHandle_t sem, TickType_t ticks);
+int host_semaphoreGiven(SemaphoreHandle_t sem);
+
+// GPIO / interrupts / RMT
+typedef int gpio_num_t;
+typedef int rmt_channel_t;
+typedef void * intr_handle_t;
+#define RMT_MODE_TX 0
+#define ETS_RMT_INTR_SOURCE 47
+esp_err_t rmt_set_pin(rmt_channel_t channel, int mode, gpio_num_t gpio);
+esp_err_t esp_intr_alloc(int source, int flags, void (*handler)(void *), void * arg, intr_handle_t * handle);
+extern void (*host_rmtIsr)(void *);
+
+#define DPORT_SET_PERI_REG_MASK(reg, mask)
+#define DPORT_CLEAR_PERI_REG_MASK(reg, mask)
+
+typedef struct {
+  union {
+    struct {
+      uint32_t duration0 :15;
+      uint32_t level0 :1;
+      uint32_t duration1 :15;
+      uint32_t level1 :1;
+    };
+    uint32_t val;
+  };
+} rmt_item32_t;
+
+typedef struct {
+  struct {
+    struct {
+      uint32_t div_cnt, mem_size, carrier_en, carrier_out_lv, mem_pd;
+    } conf0;
+    struct {
+      uint32_t tx_start, rx_en, mem_wr_rst, mem_rd_rst, apb_mem_rst, mem_owner,
+               tx_conti_mode, rx_filter_en, rx_filter_thres, ref_cnt_rst,
+               ref_always_on, idle_out_lv, idle_out_en;
+    } conf1;
+  } conf_ch[8];
+  struct { uint32_t fifo_mask, mem_tx_wrap_en; } apb_conf;
+  struct { uint32_t limit; } tx_lim_ch[8];
+  struct { uint32_t val; } int_raw, int_st, int_ena, int_clr;
+} rmt_dev_t;
+
+typedef struct {
+  struct {
+    rmt_item32_t data32[64];
+  } chan[8];
+} rmt_mem_t;
+
+extern volatile rmt_dev_t RMT;
+extern volatile rmt_mem_t RMTMEM;
+
+// Flash partitions
+typedef int esp_partition_type_t;
+typedef int esp_partition_subtype_t;
+typedef uint32_t spi_flash_mmap_handle_t;
+#define SPI_FLASH_MMAP_DATA     0
+typedef struct {
+  uint32_t address;
+  uint32_t size;
+  const char * label;
+} esp_partition_t;
+const esp_partition_t * esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char * label);
+esp_err_t esp_partition_mmap(const esp_partition_t * partition, uint32_t offset, uint32_t size, int memory,
+                             const void ** out_ptr, spi_flash_mmap_handle_t * out_handle);
+void spi_flash_munmap(spi_flash_mmap_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_IDF_H */
@@ -0,0 +1,164 @@
+/*
+ * Host implementations of the stand-in IDF / FreeRTOS APIs in host_idf.h
+ */
+
+#include "host_idf.h"
+
+#include <stdio.h>
+#include <time.h>
+
+volatile rmt_dev_t RMT;
+volatile rmt_mem_t RMTMEM;
+
+void (*host_blockHook)(SemaphoreHandle_t sem, TickType_t ticks) = NULL;
+void (*host_rmtIsr)(void *) = NULL;
+
+static TickType_t tickCount = 0;
+
+typedef struct {
+  int count;
+} hostSemaphore_t;
+
+void * heap_caps_malloc(size_t size, uint32_t caps)
+{
+  (void)caps;
+  return malloc(size);
+}
+
+int64_t esp_timer_get_time(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void vPortCPUInitializeMutex(portMUX_TYPE * mux)
+{
+  mux->locked = 0;
+}
+
+void host_enterCritical(portMUX_TYPE * mux)
+{
+  if (mux->locked) {
+    fprintf(stderr, "critical section entered twice\n");
+    abort();
+  }
+  mux->locked = 1;
+}
+
+void host_exitCritical(portMUX_TYPE * mux)
+{
+  mux->locked = 0;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+  return calloc(1, sizeof(hostSemaphore_t));
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+  hostSemaphore_t * sem = calloc(1, sizeof(hostSemaphore_t));
+  if (sem) {
+    sem->count = 1;
+  }
+  return sem;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+  free(sem);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks)
+{
+  hostSemaphore_t * sem = handle;
+  if (sem->count == 0 && host_blockHook) {
+    host_blockHook(handle, ticks);
+  }
+  if (sem->count == 0) {
+    tickCount += ticks;  // Nothing else can run: the wait times out
+    return pdFALSE;
+  }
+  sem->count--;
+  return pdTRUE;
+}
+
+int host_semaphoreGiven(SemaphoreHandle_t handle)
+{
+  return ((hostSemaphore_t *)handle)->count > 0;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+  hostSemaphore_t * sem = handle;
+  sem->count = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t handle, BaseType_t * woken)
+{
+  *woken = pdFALSE;
+  return xSemaphoreGive(handle);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+  return tickCount;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  tickCount += ticks;
+}
+
+void vTaskDelayUntil(TickType_t * wake, TickType_t period)
+{
+  *wake += period;
+  if (tickCount < *wake) {
+    tickCount = *wake;
+  }
+}
+
+BaseType_t xTaskCreate(void (*fn)(void *), const char * name, uint32_t stack, void * arg,
+                       int prio, TaskHandle_t * handle)
+{
+  (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)handle;
+  return pdFALSE;  // Tasks are not emulated
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+  (void)task;
+}
+
+esp_err_t rmt_set_pin(rmt_channel_t channel, int mode, gpio_num_t gpio)
+{
+  (void)channel; (void)mode; (void)gpio;
+  return ESP_OK;
+}
+
+esp_err_t esp_intr_alloc(int source, int flags, void (*handler)(void *), void * arg, intr_handle_t * handle)
+{
+  (void)source; (void)flags; (void)arg; (void)handle;
+  host_rmtIsr = handler;
+  return ESP_OK;
+}
+
+const esp_partition_t * esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char * label)
+{
+  (void)type; (void)subtype; (void)label;
+  return NULL;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t * partition, uint32_t offset, uint32_t size, int memory,
+                             const void ** out_ptr, spi_flash_mmap_handle_t * out_handle)
+{
+  (void)partition; (void)offset; (void)size; (void)memory; (void)out_ptr; (void)out_handle;
+  return ESP_FAIL;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle)
+{
+  (void)handle;
+}
@@ -0,0 +1,2 @@
+/* Host build configuration: PSRAM is plain heap memory here */
+#define CONFIG_SPIRAM_SUPPORT 1
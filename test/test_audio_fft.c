@@ -0,0 +1,88 @@
+/*
+ * Pure tones through the audio FFT: the strongest bin and band must be the
+ * ones the tone falls in, and a bass burst after quiet frames must beat.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "audio_fft.h"
+
+static int16_t samples[AUDIO_FFT_SIZE];
+
+static void tone(double hz, double amplitude, double phase)
+{
+  for (int i = 0; i < AUDIO_FFT_SIZE; i++) {
+    samples[i] = (int16_t)(amplitude * sin(2 * M_PI * hz * i / AUDIO_SAMPLE_RATE + phase));
+  }
+}
+
+static int checkTone(double hz)
+{
+  audioBands_t bands;
+  audioFft_init();
+  tone(hz, 12000, 0.3);
+  audioFft_analyse(samples, &bands);
+
+  int expectedBin = (int)(hz * AUDIO_FFT_SIZE / AUDIO_SAMPLE_RATE + 0.5);
+  int expectedBand = audioFft_bandOfBin(expectedBin);
+
+  int peakBin = 1;
+  for (int k = 1; k <= AUDIO_FFT_SIZE / 2; k++) {
+    if (audioFft_binPower(k) > audioFft_binPower(peakBin)) {
+      peakBin = k;
+    }
+  }
+
+  // Strongest band by mean power, the same measure the levels are built from
+  double bandPower[AUDIO_NUM_BANDS] = { 0 };
+  int bandBins[AUDIO_NUM_BANDS] = { 0 };
+  for (int k = 1; k < AUDIO_FFT_SIZE / 2; k++) {
+    int b = audioFft_bandOfBin(k);
+    bandPower[b] += audioFft_binPower(k);
+    bandBins[b]++;
+  }
+  int peakBand = 0;
+  for (int b = 0; b < AUDIO_NUM_BANDS; b++) {
+    if (bandPower[b] / bandBins[b] > bandPower[peakBand] / bandBins[peakBand]) {
+      peakBand = b;
+    }
+  }
+
+  int ok = peakBin == expectedBin && peakBand == expectedBand && bands.level[expectedBand] == 255;
+  printf("%8.1f Hz  bin %3d (expected %3d)  band %d (expected %d)  level %3d  %s\n",
+         hz, peakBin, expectedBin, peakBand, expectedBand, bands.level[expectedBand], ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+static int checkBeat()
+{
+  audioBands_t bands;
+  int beats = 0;
+  audioFft_init();
+
+  // Quiet mid-range tone, then a loud burst in the second bass band
+  tone(1000, 500, 0);
+  for (int f = 0; f < 20; f++) {
+    audioFft_analyse(samples, &bands);
+    beats += bands.beat;
+  }
+  tone(2.0 * AUDIO_SAMPLE_RATE / AUDIO_FFT_SIZE, 16000, 0);
+  audioFft_analyse(samples, &bands);
+
+  int ok = beats == 0 && bands.beat;
+  printf("beat on bass burst: %s (%d false beats before)  %s\n", bands.beat ? "yes" : "no", beats, ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+int main(void)
+{
+  static const double tones[] = { 43.1, 100, 440, 1000, 1234.5, 3000, 5000, 9000, 10900 };
+  int failed = 0;
+
+  for (size_t i = 0; i < sizeof(tones) / sizeof(tones[0]); i++) {
+    failed |= checkTone(tones[i]);
+  }
+  failed |= checkBeat();
+  return failed;
+}
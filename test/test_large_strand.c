@@ -0,0 +1,144 @@
+/*
+ * 20k-pixel strands in normal, palette and PSRAM-streamed mode
+ *
+ * Every frame must decode byte-exact off the emulated RMT. Streamed and
+ * palette strands are also run with the task waking late after each staging
+ * window is freed, to show how much slack the double-buffered stage leaves
+ * before the refill interrupt has to pack a window itself, and the refill
+ * margin: how long the handler ran against the time the other half of the
+ * channel memory takes to drain. The handler times are host timings. The
+ * median over every refill of every frame is what a strand fails on; the
+ * maximum includes preemption of the test process and is only reported.
+ *
+ * The emulator runs the task and the refill interrupt on one thread, one
+ * after the other, so it cannot reproduce the task and the interrupt packing
+ * the stage at the same time on the two cores. That is guarded by the lock
+ * in the driver, not shown by this test.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp32_digital_led_lib.h"
+#include "rmt_emulator.h"
+
+#define NUM_PIXELS 20011  // Not a multiple of the staging window
+#define FRAMES     3
+
+static const char * modeNames[] = { "normal", "palette", "stream", "stream+palette" };
+
+static uint32_t isrNs[FRAMES * RMTEMU_MAX_REFILLS];
+
+static int compareNs(const void * a, const void * b)
+{
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+static pixelColor_t patternColor(uint32_t i, uint32_t frame)
+{
+  return pixelFromRGBW(i * 7 + frame, 255 - i, i * 13 + 5, i >> 3);
+}
+
+static int runStrand(int ledType, int mode, uint32_t latencyItems)
+{
+  strand_t strand;
+  memset(&strand, 0, sizeof(strand));
+  strand.rmtChannel = 0;
+  strand.gpioNum = 16;
+  strand.ledType = ledType;
+  strand.numPixels = NUM_PIXELS;
+  strand.paletteMode = mode & 1;
+  strand.streamFromPsram = (mode & 2) != 0;
+
+  rmtEmu_init();
+  if (digitalLeds_initStrands(&strand, 1)) {
+    printf("init failed\n");
+    return 1;
+  }
+  rmtEmu_setLatency(latencyItems);
+
+  int bpp = ledParamsAll[ledType].bytesPerPixel;
+  static uint8_t expected[NUM_PIXELS * 4];
+  int failed = 0;
+  int64_t budgetNs = 0;
+  uint32_t isrCount = 0;
+
+  for (int f = 0; f < FRAMES; f++) {
+    for (int i = 0; i < NUM_PIXELS; i++) {
+      pixelColor_t color;
+      if (strand.paletteMode) {
+        uint8_t idx = (i * 5 + f) % DIGITALLEDS_PALETTE_SIZE;
+        strand.pixelIdx[i] = idx;
+        color = patternColor(idx, f);
+        strand.palette[idx] = color;
+      }
+      else {
+        color = patternColor(i, f);
+        strand.pixels[i] = color;
+      }
+      uint8_t * p = expected + i * bpp;
+      p[0] = color.g;
+      p[1] = color.r;
+      p[2] = color.b;
+      if (bpp == 4) {
+        p[3] = color.w;
+      }
+    }
+
+    int ret = digitalLeds_updatePixels(&strand);
+    const rmtEmu_channel_t * ch = rmtEmu_channel(strand.rmtChannel);
+    if (ret || ch->decodedLen != (uint32_t)(NUM_PIXELS * bpp) || memcmp(ch->decoded, expected, ch->decodedLen)) {
+      failed = 1;
+    }
+    if (f == 0 || rmtEmu_refillBudgetNs(strand.rmtChannel) < budgetNs) {
+      budgetNs = rmtEmu_refillBudgetNs(strand.rmtChannel);
+    }
+    memcpy(isrNs + isrCount, ch->isrNs, ch->isrCount * sizeof(uint32_t));
+    isrCount += ch->isrCount;
+  }
+
+  // Handler time over the refills of all frames
+  qsort(isrNs, isrCount, sizeof(uint32_t), compareNs);
+  double medianUs = isrCount ? isrNs[isrCount / 2] / 1000.0 : 0;
+  double maxUs = isrCount ? isrNs[isrCount - 1] / 1000.0 : 0;
+  double budgetUs = budgetNs / 1000.0;
+  int underrun = medianUs > budgetUs;
+
+  digitalLeds_stats_t stats;
+  digitalLeds_getStats(&strand, &stats);
+  const rmtEmu_channel_t * ch = rmtEmu_channel(strand.rmtChannel);
+  printf("%-4s  %-14s  %7u  %7u  %12u  %9.1f  %10.1f  %9.1f  %20.1f  %s\n",
+         (bpp == 4) ? "RGBW" : "RGB", modeNames[mode], latencyItems, ch->refills,
+         stats.stageStalls / FRAMES, budgetUs, medianUs, budgetUs - medianUs, budgetUs - maxUs,
+         failed ? "MISMATCH" : underrun ? "UNDERRUN" : "ok");
+  failed |= underrun;
+
+  // With a prompt task the refill never has to pack a window itself
+  if (latencyItems == 0 && stats.stageStalls) {
+    failed = 1;
+  }
+  return failed;
+}
+
+int main(void)
+{
+  static const int ledTypes[] = { LED_WS2812B_V3, LED_SK6812W_V1 };
+  static const uint32_t latencies[] = { 0, 256, 1024, 2048 };
+  int failed = 0;
+
+  printf("%d pixels, host timings\n", NUM_PIXELS);
+  printf("type  mode            latency  refills  stalls/frame  budget us  isr med us  margin us  margin at host max us\n");
+  for (size_t t = 0; t < sizeof(ledTypes) / sizeof(ledTypes[0]); t++) {
+    for (int mode = 0; mode < 4; mode++) {
+      for (size_t l = 0; l < sizeof(latencies) / sizeof(latencies[0]); l++) {
+        if (mode == 0 && latencies[l]) {
+          continue;  // Packed up front, nothing to wait for
+        }
+        failed |= runStrand(ledTypes[t], mode, latencies[l]);
+      }
+    }
+  }
+  return failed;
+}
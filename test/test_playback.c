@@ -0,0 +1,181 @@
+/*
+ * LEDF round trip: a synthetic animation is encoded with
+ * tools/encode_frames.py, mapped from the output file the way the flash
+ * partition is mapped on the device, and decoded frame by frame. Every
+ * frame must match the raw input; decode throughput and the compression
+ * ratio are reported. Hand-built files with short runs or stray bytes must be
+ * rejected.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "led_playback.h"
+
+#define NUM_FRAMES  240
+#define DECODE_LOOPS 20
+
+static int64_t nowNs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void renderFrame(uint8_t * dst, int numPixels, int bpp, int frame)
+{
+  // A comet with a fading tail over a dark strand, and a full-strand color
+  // wash every 60 frames, so both delta and key frames get used
+  int head = frame * 3 % numPixels;
+  int wash = frame % 60 < 8;
+  for (int i = 0; i < numPixels; i++) {
+    uint8_t * p = dst + i * bpp;
+    int dist = (head - i + numPixels) % numPixels;
+    int level = (dist < 24) ? 255 - dist * 10 : 0;
+    if (wash) {
+      p[0] = 40 + frame % 60 * 20;
+      p[1] = 0;
+      p[2] = 80;
+    }
+    else {
+      p[0] = level;
+      p[1] = level / 2;
+      p[2] = 0;
+    }
+    if (bpp == 4) {
+      p[3] = (dist == 0) ? 255 : 0;
+    }
+  }
+}
+
+static int runCase(int numPixels, int bpp)
+{
+  char rawPath[64], ledfPath[64], command[256];
+  snprintf(rawPath, sizeof(rawPath), "build/anim_%d_%d.raw", numPixels, bpp);
+  snprintf(ledfPath, sizeof(ledfPath), "build/anim_%d_%d.ledf", numPixels, bpp);
+
+  size_t frameBytes = (size_t)numPixels * bpp;
+  uint8_t * raw = malloc(frameBytes * NUM_FRAMES);
+  for (int f = 0; f < NUM_FRAMES; f++) {
+    renderFrame(raw + f * frameBytes, numPixels, bpp, f);
+  }
+  FILE * out = fopen(rawPath, "wb");
+  if (out == NULL || fwrite(raw, frameBytes, NUM_FRAMES, out) != NUM_FRAMES || fclose(out)) {
+    printf("cannot write %s\n", rawPath);
+    return 1;
+  }
+
+  snprintf(command, sizeof(command), "%s %s -n %d -b %d -r 30 %s %s > /dev/null",
+           PYTHON, ENCODE_FRAMES, numPixels, bpp, rawPath, ledfPath);
+  if (system(command)) {
+    printf("encoder failed: %s\n", command);
+    return 1;
+  }
+
+  int fd = open(ledfPath, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st)) {
+    printf("cannot open %s\n", ledfPath);
+    return 1;
+  }
+  const uint8_t * data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return 1;
+  }
+
+  playbackDecoder_t decoder;
+  pixelColor_t * pixels = calloc(numPixels, sizeof(pixelColor_t));
+  int failed = playback_openDecoder(&decoder, data, st.st_size) != 0 ||
+               decoder.header->numFrames != NUM_FRAMES || decoder.header->numPixels != (uint32_t)numPixels;
+
+  // First pass checks every frame against the input
+  for (int f = 0; f < NUM_FRAMES && !failed; f++) {
+    failed |= playback_decodeFrame(&decoder, pixels, numPixels) != 0;
+    const uint8_t * expected = raw + f * frameBytes;
+    for (int i = 0; i < numPixels && !failed; i++) {
+      const uint8_t * p = expected + i * bpp;
+      failed |= pixels[i].r != p[0] || pixels[i].g != p[1] || pixels[i].b != p[2] ||
+                pixels[i].w != ((bpp == 4) ? p[3] : 0);
+    }
+  }
+
+  // Then time whole passes; the decoder wraps back to the first frame
+  int64_t start = nowNs();
+  for (int n = 0; n < DECODE_LOOPS * NUM_FRAMES && !failed; n++) {
+    failed |= playback_decodeFrame(&decoder, pixels, numPixels) != 0;
+  }
+  double seconds = (nowNs() - start) / 1e9;
+  // Frames out, and encoded bytes read: deltas only touch the changed pixels
+  double mbPerSecOut = (double)frameBytes * NUM_FRAMES * DECODE_LOOPS / seconds / 1e6;
+  double mbPerSecIn = (double)(st.st_size - sizeof(playbackHeader_t)) * DECODE_LOOPS / seconds / 1e6;
+  double usPerFrame = seconds * 1e6 / (DECODE_LOOPS * NUM_FRAMES);
+
+  printf("%5d px  %d bpp  %8zu -> %7lld bytes  %5.1f:1  %8.1f  %8.1f  %9.2f  %s\n",
+         numPixels, bpp, frameBytes * NUM_FRAMES, (long long)st.st_size,
+         (double)frameBytes * NUM_FRAMES / st.st_size, mbPerSecOut, mbPerSecIn, usPerFrame, failed ? "FAIL" : "ok");
+
+  munmap((void *)data, st.st_size);
+  free(pixels);
+  free(raw);
+  return failed;
+}
+
+static uint32_t appendFrame(uint8_t * dst, uint8_t type, const uint8_t * payload, uint32_t len)
+{
+  playbackFrameHeader_t frameHeader = { type, { 0 }, len };
+  memcpy(dst, &frameHeader, sizeof(frameHeader));
+  memcpy(dst + sizeof(frameHeader), payload, len);
+  return sizeof(frameHeader) + len;
+}
+
+// A 4-pixel RGB file of a valid key frame followed by the given frame, which
+// the decoder must accept or reject as expected
+static int checkSecondFrame(const char * name, uint8_t type, const uint8_t * payload, uint32_t len, int expected)
+{
+  static const uint8_t key[] = { 4, 10, 20, 30 };
+  uint8_t file[128];
+  playbackHeader_t header = { PLAYBACK_MAGIC, PLAYBACK_VERSION, 3, 30, 4, 2 };
+  uint32_t size = sizeof(header);
+  memcpy(file, &header, sizeof(header));
+  size += appendFrame(file + size, FRAME_KEY, key, sizeof(key));
+  size += appendFrame(file + size, type, payload, len);
+
+  playbackDecoder_t decoder;
+  pixelColor_t pixels[4];
+  int ret = playback_openDecoder(&decoder, file, size) || playback_decodeFrame(&decoder, pixels, 4) ||
+            playback_decodeFrame(&decoder, pixels, 4);
+  int ok = (ret ? -1 : 0) == expected;
+  printf("%-28s %-8s %s\n", name, ret ? "rejected" : "accepted", ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+int main(void)
+{
+  int failed = 0;
+  printf("strand       raw -> encoded            ratio  MB/s out   MB/s in  us/frame\n");
+  failed |= runCase(300, 3);
+  failed |= runCase(300, 4);
+  failed |= runCase(1000, 4);
+
+  static const uint8_t keyFull[] = { 2, 1, 2, 3, 2, 4, 5, 6 };
+  static const uint8_t keyShort[] = { 3, 1, 2, 3 };
+  static const uint8_t keyTrailing[] = { 4, 1, 2, 3, 9 };
+  static const uint8_t deltaFull[] = { 1, 2, 1, 2, 3, 4, 5, 6 };
+  static const uint8_t deltaTrailing[] = { 1, 1, 1, 2, 3, 9 };
+  static const uint8_t deltaPastEnd[] = { 3, 2, 1, 2, 3, 4, 5, 6 };
+  printf("\n");
+  failed |= checkSecondFrame("key frame", FRAME_KEY, keyFull, sizeof(keyFull), 0);
+  failed |= checkSecondFrame("key frame short of strand", FRAME_KEY, keyShort, sizeof(keyShort), -1);
+  failed |= checkSecondFrame("key frame with stray byte", FRAME_KEY, keyTrailing, sizeof(keyTrailing), -1);
+  failed |= checkSecondFrame("delta frame", FRAME_DELTA, deltaFull, sizeof(deltaFull), 0);
+  failed |= checkSecondFrame("delta frame with stray byte", FRAME_DELTA, deltaTrailing, sizeof(deltaTrailing), -1);
+  failed |= checkSecondFrame("delta frame past strand", FRAME_DELTA, deltaPastEnd, sizeof(deltaPastEnd), -1);
+  return failed;
+}
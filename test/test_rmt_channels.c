@@ -0,0 +1,133 @@
+/*
+ * RMT channel and memory allocation
+ *
+ * With DIGITALLEDS_AUTO_CHANNEL on every strand, digitalLeds_initStrands()
+ * must give 1 to 8 strands their own channel and an even share of the 8
+ * memory blocks, with no two channels overlapping. Each strand then sends a
+ * frame through the emulated RMT, which has to decode byte-exact; the report
+ * shows the interrupts that frame took. Channels chosen by the caller must be
+ * kept, each growing up to the next one and leaving the channels below the
+ * first alone, and duplicate, out of range or partly automatic sets rejected.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp32_digital_led_lib.h"
+#include "rmt_emulator.h"
+
+#include <soc/rmt_struct.h>
+
+#define NUM_PIXELS 300
+
+static int runStrands(int numStrands)
+{
+  strand_t strands[8];
+  memset(strands, 0, sizeof(strands));
+  for (int i = 0; i < numStrands; i++) {
+    strands[i].rmtChannel = DIGITALLEDS_AUTO_CHANNEL;
+    strands[i].gpioNum = 16 + i;
+    strands[i].ledType = LED_WS2812B_V3;
+    strands[i].numPixels = NUM_PIXELS;
+  }
+
+  rmtEmu_init();
+  if (digitalLeds_initStrands(strands, numStrands)) {
+    printf("%d strands: init failed\n", numStrands);
+    return 1;
+  }
+
+  int failed = 0;
+  int blocksUsed = 0;
+  uint32_t interrupts = 0;
+  char channels[64] = "", blocks[64] = "";
+
+  for (int i = 0; i < numStrands; i++) {
+    strand_t * pStrand = &strands[i];
+    uint8_t expected[NUM_PIXELS * 3];
+    for (int p = 0; p < NUM_PIXELS; p++) {
+      pStrand->pixels[p] = pixelFromRGB(p + i, p * 3, 255 - p);
+      expected[p * 3 + 0] = pStrand->pixels[p].g;
+      expected[p * 3 + 1] = pStrand->pixels[p].r;
+      expected[p * 3 + 2] = pStrand->pixels[p].b;
+    }
+    failed |= digitalLeds_updatePixels(pStrand) != 0;
+
+    const rmtEmu_channel_t * ch = rmtEmu_channel(pStrand->rmtChannel);
+    failed |= ch->decodedLen != sizeof(expected) || memcmp(ch->decoded, expected, sizeof(expected));
+
+    // Channels must be in order and each must stop short of the next one's block
+    int nextChannel = (i + 1 < numStrands) ? strands[i + 1].rmtChannel : 8;
+    failed |= ch->memBlocks < 8 / numStrands || pStrand->rmtChannel + (int)ch->memBlocks != nextChannel;
+
+    blocksUsed += ch->memBlocks;
+    interrupts += ch->refills + 1;  // Threshold refills plus tx_end
+    snprintf(channels + strlen(channels), sizeof(channels) - strlen(channels), "%s%d", i ? "," : "", pStrand->rmtChannel);
+    snprintf(blocks + strlen(blocks), sizeof(blocks) - strlen(blocks), "%s%u", i ? "," : "", ch->memBlocks);
+  }
+  failed |= blocksUsed != 8;
+
+  printf("%d  %-16s %-16s %16u  %9u  %s\n", numStrands, channels, blocks,
+         interrupts / numStrands, interrupts, failed ? "FAIL" : "ok");
+  return failed;
+}
+
+// Initialises strands on the given channels; expectedBlocks is NULL when the
+// set must be rejected
+static int checkChannels(const char * name, const int * channels, int numStrands, const int * expectedBlocks)
+{
+  strand_t strands[8];
+  memset(strands, 0, sizeof(strands));
+  for (int i = 0; i < numStrands; i++) {
+    strands[i].rmtChannel = channels[i];
+    strands[i].gpioNum = 16 + i;
+    strands[i].ledType = LED_WS2812B_V3;
+    strands[i].numPixels = NUM_PIXELS;
+  }
+
+  rmtEmu_init();
+  int ret = digitalLeds_initStrands(strands, numStrands);
+  int ok;
+  if (expectedBlocks == NULL) {
+    ok = ret == -1;
+  }
+  else {
+    ok = ret == 0;
+    for (int ch = 0; ch < 8 && ok; ch++) {
+      // Channels not given to a strand must be left unconfigured
+      int blocks = 0;
+      for (int i = 0; i < numStrands; i++) {
+        if (strands[i].rmtChannel == ch) {
+          ok &= channels[i] == ch;
+          blocks = expectedBlocks[i];
+        }
+      }
+      ok &= (int)RMT.conf_ch[ch].conf0.mem_size == blocks;
+    }
+  }
+  printf("%-28s %-8s %s\n", name, ret ? "rejected" : "accepted", ok ? "ok" : "FAIL");
+  return !ok;
+}
+
+int main(void)
+{
+  int failed = 0;
+  printf("%d-pixel RGB strands\n", NUM_PIXELS);
+  printf("n  channels         blocks           irq/strand/frame  irq/frame\n");
+  for (int n = 1; n <= 8; n++) {
+    failed |= runStrands(n);
+  }
+
+  static const int spaced[] = { 0, 4 }, spacedBlocks[] = { 4, 4 };
+  static const int highFirst[] = { 5, 2 }, highFirstBlocks[] = { 3, 3 };
+  static const int duplicate[] = { 3, 3 };
+  static const int outOfRange[] = { 1, 8 };
+  static const int partlyAuto[] = { DIGITALLEDS_AUTO_CHANNEL, 2 };
+  printf("\n");
+  failed |= checkChannels("channels 0,4", spaced, 2, spacedBlocks);
+  failed |= checkChannels("channels 5,2", highFirst, 2, highFirstBlocks);
+  failed |= checkChannels("channels 3,3", duplicate, 2, NULL);
+  failed |= checkChannels("channels 1,8", outOfRange, 2, NULL);
+  failed |= checkChannels("channels auto,2", partlyAuto, 2, NULL);
+  return failed;
+}
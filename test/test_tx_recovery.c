@@ -0,0 +1,102 @@
+/*
+ * Recovery from a transmit that never ends
+ *
+ * The emulated channel stalls halfway through a frame, so the driver times
+ * out and resets it. The stalled transmitter then carries on from item 0 of
+ * whatever the channel memory holds, a few hundred items at a time while the
+ * driver prepares the next frame. Every later frame must still decode
+ * byte-exact, with no early completion, and the stats must count one timeout
+ * and one recovery.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp32_digital_led_lib.h"
+#include "rmt_emulator.h"
+
+#define NUM_PIXELS 300
+
+static void fillFrame(strand_t * pStrand, int frame, uint8_t * expected)
+{
+  for (int p = 0; p < NUM_PIXELS; p++) {
+    pixelColor_t color = pixelFromRGB(p * 5 + frame * 40, frame * 17, 255 - p);
+    pStrand->pixels[p] = color;
+    expected[p * 3 + 0] = color.g;
+    expected[p * 3 + 1] = color.r;
+    expected[p * 3 + 2] = color.b;
+  }
+}
+
+static int runCase(int numStrands, uint32_t latencyItems)
+{
+  strand_t strands[2];
+  memset(strands, 0, sizeof(strands));
+  for (int i = 0; i < numStrands; i++) {
+    strands[i].rmtChannel = DIGITALLEDS_AUTO_CHANNEL;
+    strands[i].gpioNum = 16 + i;
+    strands[i].ledType = LED_WS2812B_V3;
+    strands[i].numPixels = NUM_PIXELS;
+  }
+
+  rmtEmu_init();
+  if (digitalLeds_initStrands(strands, numStrands)) {
+    return 1;
+  }
+  rmtEmu_setLatency(latencyItems);
+
+  strand_t * pStrand = &strands[0];
+  int channel = pStrand->rmtChannel;
+  uint8_t expected[NUM_PIXELS * 3];
+  int failed = 0;
+  int badFrames = 0;
+
+  for (int frame = 0; frame < 6; frame++) {
+    if (frame == 2) {
+      rmtEmu_stall(channel);
+    }
+    fillFrame(pStrand, frame, expected);
+    uint32_t emuFrames = rmtEmu_channel(channel)->frames;
+    int ret = digitalLeds_updatePixels(pStrand);
+
+    if (frame == 2) {
+      failed |= ret != -1;
+      continue;
+    }
+    // Exactly one transmission must have ended, and it must be this frame
+    const rmtEmu_channel_t * ch = rmtEmu_channel(channel);
+    if (ret != 0 || ch->frames == emuFrames || ch->decodedLen != sizeof(expected) ||
+        memcmp(ch->decoded, expected, sizeof(expected))) {
+      badFrames++;
+    }
+    // The other strand must not be disturbed by the reset
+    if (numStrands > 1) {
+      fillFrame(&strands[1], frame, expected);
+      ret = digitalLeds_updatePixels(&strands[1]);
+      ch = rmtEmu_channel(strands[1].rmtChannel);
+      if (ret != 0 || memcmp(ch->decoded, expected, sizeof(expected))) {
+        badFrames++;
+      }
+    }
+  }
+
+  digitalLeds_stats_t stats;
+  digitalLeds_getStats(pStrand, &stats);
+  failed |= badFrames || stats.timeouts != 1 || stats.recoveries != 1 || stats.droppedFrames != 1;
+  printf("%d strand(s)  latency %4u items  frames %u  timeouts %u  recoveries %u  dropped %u  bad frames %d  %s\n",
+         numStrands, latencyItems, stats.frames, stats.timeouts, stats.recoveries, stats.droppedFrames,
+         badFrames, failed ? "FAIL" : "ok");
+  return failed;
+}
+
+int main(void)
+{
+  static const uint32_t latencies[] = { 0, 1, 64, 256 };
+  int failed = 0;
+  for (int n = 1; n <= 2; n++) {
+    for (size_t l = 0; l < sizeof(latencies) / sizeof(latencies[0]); l++) {
+      failed |= runCase(n, latencies[l]);
+    }
+  }
+  return failed;
+}
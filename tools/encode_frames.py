@@ -0,0 +1,100 @@
+#!/usr/bin/env python
+"""
+Encode raw RGB(W) frames into the LEDF playback format read by led_playback.
+
+The input is a flat file of frames, each numPixels * bpp bytes in RGB(W)
+order. Every frame after the first is stored as whichever of a key (RLE)
+or delta frame is smaller. Flash the result into the "frames" partition:
+
+    python tools/encode_frames.py -n 300 -b 4 -r 30 anim.raw frames.bin
+    esptool.py write_flash 0x110000 frames.bin
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b'LEDF'
+VERSION = 1
+FRAME_KEY = 0
+FRAME_DELTA = 1
+
+
+def encode_key(pixels):
+    out = bytearray()
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while run < 255 and i + run < len(pixels) and pixels[i + run] == pixels[i]:
+            run += 1
+        out.append(run)
+        out += pixels[i]
+        i += run
+    return out
+
+
+def encode_delta(prev, pixels):
+    out = bytearray()
+    i = 0
+    while i < len(pixels):
+        skip = 0
+        while skip < 255 and i + skip < len(pixels) and pixels[i + skip] == prev[i + skip]:
+            skip += 1
+        i += skip
+        count = 0
+        while count < 255 and i + count < len(pixels) and pixels[i + count] != prev[i + count]:
+            count += 1
+        if i >= len(pixels) and count == 0:
+            break  # Trailing unchanged pixels need no group
+        out.append(skip)
+        out.append(count)
+        for p in pixels[i:i + count]:
+            out += p
+        i += count
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('-n', '--pixels', type=int, required=True, help='pixels per frame')
+    parser.add_argument('-b', '--bpp', type=int, choices=(3, 4), default=3, help='bytes per pixel')
+    parser.add_argument('-r', '--fps', type=int, default=30, help='playback frame rate')
+    parser.add_argument('-k', '--keyframe-interval', type=int, default=0,
+                        help='force a key frame every N frames (0: only when smaller)')
+    parser.add_argument('input')
+    parser.add_argument('output')
+    args = parser.parse_args()
+
+    frame_size = args.pixels * args.bpp
+    with open(args.input, 'rb') as f:
+        raw = f.read()
+    if len(raw) == 0 or len(raw) % frame_size:
+        sys.exit('%s: size is not a multiple of %d-byte frames' % (args.input, frame_size))
+    num_frames = len(raw) // frame_size
+
+    out = bytearray(MAGIC + struct.pack('<BBHII', VERSION, args.bpp, args.fps, args.pixels, num_frames))
+    prev = None
+    keys = 0
+    for n in range(num_frames):
+        data = raw[n * frame_size:(n + 1) * frame_size]
+        pixels = [bytes(data[i:i + args.bpp]) for i in range(0, frame_size, args.bpp)]
+
+        frame_type, payload = FRAME_KEY, encode_key(pixels)
+        forced = args.keyframe_interval and n % args.keyframe_interval == 0
+        if prev is not None and not forced:
+            delta = encode_delta(prev, pixels)
+            if len(delta) < len(payload):
+                frame_type, payload = FRAME_DELTA, delta
+        keys += frame_type == FRAME_KEY
+
+        out += struct.pack('<B3xI', frame_type, len(payload)) + payload
+        prev = pixels
+
+    with open(args.output, 'wb') as f:
+        f.write(out)
+    print('%d frames (%d key), %d -> %d bytes, ratio %.1f:1' %
+          (num_frames, keys, len(raw), len(out), float(len(raw)) / len(out)))
+
+
+if __name__ == '__main__':
+    main()